@@ -0,0 +1,56 @@
+#include "allocations.hpp"
+
+#include <cstdlib>
+#include <new>
+
+std::atomic<unsigned long> Allocations(0);
+
+// replaces the whole set of plain and array forms, so every new meets a matching delete
+static void *allocate(size_t size) {
+  Allocations.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size ? size : 1);
+}
+
+void *operator new(size_t size) {
+  if (void *memory = allocate(size))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) {
+  if (void *memory = allocate(size))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size);
+}
+
+void operator delete(void *memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void *memory, const std::nothrow_t &) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void *memory, const std::nothrow_t &) noexcept {
+  std::free(memory);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <atomic>
+
+// Every heap allocation in the process, so the tick loop can report allocations per tick. The
+// counting operator new/delete live in their own file: inlined next to their callers gcc can't
+// tell them from the library's and warns about mismatched new/free pairs.
+extern std::atomic<unsigned long> Allocations;
@@ -0,0 +1,367 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "allocations.hpp"
+#include "collision.hpp"
+#include "game.hpp"
+#include "input_replay.hpp"
+#include "level_data.hpp"
+#include "render_state.hpp"
+#include "resource_manager.hpp"
+
+// Benchmarks the simulation by replaying sessions headlessly, the render path against whatever GL
+// the machine offers (run with LIBGL_ALWAYS_SOFTWARE=1 for Mesa llvmpipe) and a few hot kernels.
+// Run from the game directory:
+//   bench [--ticks N] [--frames N] [--render] [--json FILE] [session.rpl...]
+// Without sessions a built-in synthetic one is replayed. Results are written as JSON.
+
+const unsigned int SCREEN_WIDTH = 800;
+const unsigned int SCREEN_HEIGHT = 600;
+const float SIM_STEP = 1.0f / 240.0f;
+
+Game Breakout(SCREEN_WIDTH, SCREEN_HEIGHT);
+
+struct Metric {
+  std::string Name;
+  double Value;
+};
+
+struct Result {
+  std::string Suite;
+  std::string Name;
+  std::vector<Metric> Metrics;
+  std::string Note;
+};
+
+std::vector<Result> Results;
+
+typedef std::chrono::steady_clock Clock;
+
+static double microseconds(Clock::time_point start, Clock::time_point end) {
+  return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+// nearest-rank percentile, sorts samples
+static double percentile(std::vector<double> &samples, double p) {
+  if (samples.empty())
+    return 0.0;
+  std::sort(samples.begin(), samples.end());
+  size_t rank = std::min(samples.size() - 1, (size_t)(p / 100.0 * samples.size()));
+  return samples[rank];
+}
+
+static void report(const Result &result) {
+  std::cout << result.Suite << "/" << result.Name << ":";
+  for (const Metric &metric : result.Metrics)
+    std::cout << " " << metric.Name << "=" << metric.Value;
+  if (!result.Note.empty())
+    std::cout << " (" << result.Note << ")";
+  std::cout << "\n";
+  Results.push_back(result);
+}
+
+// holds SPACE and sweeps the paddle left and right, so the ball keeps meeting bricks and paddle
+static void syntheticInput(unsigned long tick, bool *keys) {
+  unsigned long phase = tick % 480;
+  keys[GLFW_KEY_SPACE] = true;
+  keys[GLFW_KEY_A] = phase < 120;
+  keys[GLFW_KEY_D] = phase >= 240 && phase < 360;
+}
+
+static void replaySession(const std::string &name, unsigned long ticks, float step, bool ccd, const std::function<void(unsigned long, bool *)> &input,
+                          const uint64_t *expectedHash) {
+  ResourceManager::Headless = true;
+  Breakout.ContinuousCollision = ccd;
+  std::memset(Breakout.Keys, 0, sizeof(Breakout.Keys));
+  Breakout.Init();
+
+  std::vector<double> samples;
+  samples.reserve(ticks);
+
+  unsigned long allocations = Allocations.load();
+  Clock::time_point start = Clock::now();
+  for (unsigned long tick = 0; tick < ticks; tick++) {
+    input(tick, Breakout.Keys);
+    Clock::time_point before = Clock::now();
+    Breakout.Tick(step);
+    samples.push_back(microseconds(before, Clock::now()));
+  }
+  double total = microseconds(start, Clock::now());
+  allocations = Allocations.load() - allocations;
+
+  Result result{ "replay", name, { }, "" };
+  result.Metrics.push_back({ "ticks", (double)ticks });
+  result.Metrics.push_back({ "ticks_per_second", ticks / (total * 1e-6) });
+  result.Metrics.push_back({ "p50_us", percentile(samples, 50.0) });
+  result.Metrics.push_back({ "p99_us", percentile(samples, 99.0) });
+  result.Metrics.push_back({ "max_us", samples.empty() ? 0.0 : samples.back() });
+  result.Metrics.push_back({ "allocations_per_tick", ticks ? (double)allocations / ticks : 0.0 });
+
+  uint64_t hash = Breakout.StateHash();
+  char text[64];
+  std::snprintf(text, sizeof(text), "state %016llx", (unsigned long long)hash);
+  result.Note = text;
+  if (expectedHash)
+    result.Note += hash == *expectedHash ? ", matches recording" : ", differs from recording";
+  report(result);
+
+  ResourceManager::Clear();
+}
+
+static void replayFile(const char *file) {
+  InputPlayer player;
+  if (!player.Load(file))
+    return;
+
+  replaySession(file, player.Header.Ticks, player.Header.Step, player.Header.Flags & REPLAY_FLAG_CCD,
+                [&player](unsigned long, bool *keys) { player.Apply(keys); }, &player.Header.FinalHash);
+}
+
+static void renderSuite(unsigned long frames) {
+  Result result{ "render", "submit", { }, "" };
+
+  glfwInit();
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE, false);
+  GLFWwindow *window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Breakout bench", nullptr, nullptr);
+  if (!window) {
+    result.Note = "skipped, no GL 4.6 context";
+    report(result);
+    glfwTerminate();
+    return;
+  }
+  glfwMakeContextCurrent(window);
+  glfwSwapInterval(0);
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    result.Note = "skipped, failed to load GL";
+    report(result);
+    glfwTerminate();
+    return;
+  }
+  result.Note = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+
+  glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  ResourceManager::Headless = false;
+  Breakout.ContinuousCollision = false;
+  std::memset(Breakout.Keys, 0, sizeof(Breakout.Keys));
+  RenderState::Invalidate();
+  Breakout.Init();
+
+  // CPU time spent issuing a frame; the GPU is drained outside the measurement
+  std::vector<double> samples;
+  double binds = 0.0, skipped = 0.0;
+  for (unsigned long frame = 0; frame < frames; frame++) {
+    syntheticInput(frame, Breakout.Keys);
+    Breakout.Tick(SIM_STEP);
+
+    Clock::time_point before = Clock::now();
+    glClear(GL_COLOR_BUFFER_BIT);
+    Breakout.Render();
+    samples.push_back(microseconds(before, Clock::now()));
+
+    glfwSwapBuffers(window);
+    glFinish();
+    RenderState::NewFrame();
+    binds += RenderState::LastFrame.BindsIssued;
+    skipped += RenderState::LastFrame.BindsSkipped;
+  }
+  result.Metrics.push_back({ "frames", (double)frames });
+  result.Metrics.push_back({ "p50_us", percentile(samples, 50.0) });
+  result.Metrics.push_back({ "p99_us", percentile(samples, 99.0) });
+  result.Metrics.push_back({ "binds_per_frame", frames ? binds / frames : 0.0 });
+  result.Metrics.push_back({ "binds_skipped_per_frame", frames ? skipped / frames : 0.0 });
+  report(result);
+
+  // uniform uploads by name (reflected table search) against a resolved handle
+  const unsigned int UNIFORM_CALLS = 100000;
+  Shader &shader = ResourceManager::Get(ResourceManager::FindShader("sprite")).Use();
+  UniformHandle<glm::vec3> color = shader.Uniform<glm::vec3>("spriteColor");
+  Clock::time_point start = Clock::now();
+  for (unsigned int i = 0; i < UNIFORM_CALLS; i++)
+    shader.SetVec3("spriteColor", glm::vec3(i & 1));
+  double byName = microseconds(start, Clock::now());
+  start = Clock::now();
+  for (unsigned int i = 0; i < UNIFORM_CALLS; i++)
+    shader.Set(color, glm::vec3(i & 1));
+  double byHandle = microseconds(start, Clock::now());
+  glFinish();
+  report({ "render", "uniforms", { { "by_name_ns", byName * 1000.0 / UNIFORM_CALLS }, { "by_handle_ns", byHandle * 1000.0 / UNIFORM_CALLS } }, "" });
+
+  Breakout.Clear();
+  ResourceManager::Clear();
+  glfwDestroyWindow(window);
+  glfwTerminate();
+}
+
+static void kernelSuite() {
+  const unsigned int BATCHES = 4096, ROUNDS = 64;
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> coord(0.0f, 800.0f), extent(10.0f, 80.0f);
+
+  std::vector<float> x(BATCHES * 64), y(BATCHES * 64), w(BATCHES * 64), h(BATCHES * 64);
+  for (unsigned int i = 0; i < x.size(); i++) {
+    x[i] = coord(rng);
+    y[i] = coord(rng);
+    w[i] = extent(rng);
+    h[i] = extent(rng);
+  }
+  std::vector<glm::vec2> centers(BATCHES);
+  for (glm::vec2 &center : centers)
+    center = glm::vec2(coord(rng), coord(rng));
+  const float radius = 12.5f;
+
+  uint64_t simdHits = 0, scalarHits = 0;
+  Clock::time_point start = Clock::now();
+  for (unsigned int round = 0; round < ROUNDS; round++) {
+    for (unsigned int b = 0; b < BATCHES; b++) {
+      unsigned int base = b * 64;
+      simdHits += CollideCircleAABBs(centers[b], radius, &x[base], &y[base], &w[base], &h[base], 64).Mask != 0;
+    }
+  }
+  double simd = microseconds(start, Clock::now());
+
+  start = Clock::now();
+  for (unsigned int round = 0; round < ROUNDS; round++) {
+    for (unsigned int b = 0; b < BATCHES; b++) {
+      uint64_t mask = 0;
+      for (unsigned int i = b * 64; i < b * 64 + 64; i++) {
+        glm::vec2 closest = glm::clamp(centers[b], glm::vec2(x[i], y[i]), glm::vec2(x[i] + w[i], y[i] + h[i]));
+        glm::vec2 d = centers[b] - closest;
+        mask |= (uint64_t)(glm::dot(d, d) <= radius * radius) << (i - b * 64);
+      }
+      scalarHits += mask != 0;
+    }
+  }
+  double scalar = microseconds(start, Clock::now());
+
+  Result result{ "kernel", "circle_aabb_x64", { }, "" };
+  result.Metrics.push_back({ "simd_ns_per_batch", simd * 1000.0 / (BATCHES * ROUNDS) });
+  result.Metrics.push_back({ "scalar_ns_per_batch", scalar * 1000.0 / (BATCHES * ROUNDS) });
+  if (simdHits != scalarHits)
+    result.Note = "hit counts disagree";
+  result.Note += result.Note.empty() ? CollisionKernel() : std::string(", ") + CollisionKernel();
+  report(result);
+}
+
+static void parserSuite() {
+  const unsigned int WIDTH = 2000, HEIGHT = 2000, ROUNDS = 5;
+  std::mt19937 rng(7);
+  std::string text;
+  text.reserve(WIDTH * HEIGHT * 2);
+  for (unsigned int y = 0; y < HEIGHT; y++) {
+    for (unsigned int x = 0; x < WIDTH; x++) {
+      text += (char)('0' + rng() % 6);
+      text += x + 1 < WIDTH ? ' ' : '\n';
+    }
+  }
+
+  LevelData level;
+  LevelError error;
+  Clock::time_point start = Clock::now();
+  for (unsigned int round = 0; round < ROUNDS; round++)
+    ParseLevelText(text.data(), text.size(), level, error);
+  double parse = microseconds(start, Clock::now()) / ROUNDS;
+
+  std::string file = (std::filesystem::temp_directory_path() / "breakout-bench.blvl").string();
+  std::vector<char> binary;
+  if (WriteLevelBinary(file.c_str(), level, true)) {
+    std::ifstream in(file, std::ios::binary);
+    binary.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    std::remove(file.c_str());
+  }
+  start = Clock::now();
+  for (unsigned int round = 0; round < ROUNDS; round++)
+    ReadLevelBinary(reinterpret_cast<const uint8_t *>(binary.data()), binary.size(), level, error);
+  double read = microseconds(start, Clock::now()) / ROUNDS;
+
+  Result result{ "parser", "level_2000x2000", { }, "" };
+  result.Metrics.push_back({ "text_mb_per_second", text.size() / parse });
+  result.Metrics.push_back({ "text_ms", parse / 1000.0 });
+  result.Metrics.push_back({ "binary_rle_ms", read / 1000.0 });
+  report(result);
+}
+
+static std::string escape(const std::string &text) {
+  std::string escaped;
+  for (char c : text) {
+    if (c == '"' || c == '\\')
+      escaped += '\\';
+    escaped += c;
+  }
+  return escaped;
+}
+
+static bool writeJson(const char *file) {
+  std::ofstream out(file);
+  out << "{\n  \"compiler\": \"" << escape(__VERSION__) << "\",\n  \"results\": [\n";
+  for (size_t i = 0; i < Results.size(); i++) {
+    const Result &result = Results[i];
+    out << "    { \"suite\": \"" << result.Suite << "\", \"name\": \"" << escape(result.Name) << "\"";
+    for (const Metric &metric : result.Metrics)
+      out << ", \"" << metric.Name << "\": " << metric.Value;
+    if (!result.Note.empty())
+      out << ", \"note\": \"" << escape(result.Note) << "\"";
+    out << " }" << (i + 1 < Results.size() ? ",\n" : "\n");
+  }
+  out << "  ]\n}\n";
+  return static_cast<bool>(out);
+}
+
+int main(int argc, char *argv[]) {
+  unsigned long ticks = 200000, frames = 2000;
+  bool render = false;
+  const char *json = "bench.json";
+  std::vector<const char *> sessions;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+      ticks = std::strtoul(argv[++i], nullptr, 10);
+    else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+      frames = std::strtoul(argv[++i], nullptr, 10);
+    else if (std::strcmp(argv[i], "--render") == 0)
+      render = true;
+    else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+      json = argv[++i];
+    else
+      sessions.push_back(argv[i]);
+  }
+
+  if (sessions.empty()) {
+    replaySession("synthetic", ticks, SIM_STEP, false, syntheticInput, nullptr);
+    replaySession("synthetic_ccd", ticks, SIM_STEP, true, syntheticInput, nullptr);
+  }
+  for (const char *session : sessions)
+    replayFile(session);
+
+  kernelSuite();
+  parserSuite();
+  if (render)
+    renderSuite(frames);
+
+  if (!writeJson(json)) {
+    std::cerr << "Error: Failed to write " << json << "\n";
+    return 1;
+  }
+  std::cout << "Wrote " << json << "\n";
+  return 0;
+}
@@ -0,0 +1,11 @@
+#version 460 core
+in vec2 TexCoords;
+in vec3 BrickColor;
+
+out vec4 color;
+
+uniform sampler2D image;
+
+void main() {
+    color = vec4(BrickColor, 1.0) * texture(image, TexCoords);
+}
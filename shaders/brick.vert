@@ -0,0 +1,18 @@
+#version 460 core
+
+layout (location = 0) in vec4 vertex;
+layout (location = 1) in vec2 instancePosition;
+layout (location = 2) in vec2 instanceSize;
+layout (location = 3) in vec3 instanceColor;
+layout (location = 4) in vec4 instanceUV;
+
+out vec2 TexCoords;
+out vec3 BrickColor;
+
+uniform mat4 projection;
+
+void main() {
+    TexCoords = mix(instanceUV.xy, instanceUV.zw, vertex.zw);
+    BrickColor = instanceColor;
+    gl_Position = projection * vec4(instancePosition + vertex.xy * instanceSize, 0.0, 1.0);
+}
@@ -1,13 +1,17 @@
 #version 460 core
 
 layout (location = 0) in vec4 vertex;
+layout (location = 1) in vec3 vertexColor;
 
 out vec2 TexCoords;
+out vec3 VertexColor;
 
 uniform mat4 model;
 uniform mat4 projection;
+uniform vec4 uvRect;
 
 void main() {
-    TexCoords = vertex.zw;
+    TexCoords = mix(uvRect.xy, uvRect.zw, vertex.zw);
+    VertexColor = vertexColor;
     gl_Position = projection * model * vec4(vertex.xy, 0.0, 1.0);
 }
@@ -0,0 +1,25 @@
+#include "brick_array.hpp"
+
+void BrickArray::Clear() {
+  X.clear();
+  Y.clear();
+  W.clear();
+  H.clear();
+  SolidBits.clear();
+  DestroyedBits.clear();
+}
+
+void BrickArray::Add(glm::vec2 position, glm::vec2 size, bool solid) {
+  unsigned int index = Count();
+  if ((index & 63) == 0) {
+    SolidBits.push_back(0);
+    DestroyedBits.push_back(0);
+  }
+
+  X.push_back(position.x);
+  Y.push_back(position.y);
+  W.push_back(size.x);
+  H.push_back(size.y);
+  if (solid)
+    SolidBits[index >> 6] |= uint64_t(1) << (index & 63);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Structure-of-arrays brick storage: only what collision and win checks read, packed tightly.
+// Rendering attributes live in the level's instance data.
+class BrickArray {
+public:
+  std::vector<float> X, Y, W, H;
+  std::vector<uint64_t> SolidBits, DestroyedBits;
+
+  unsigned int Count() const { return X.size(); }
+
+  void Clear();
+  void Add(glm::vec2 position, glm::vec2 size, bool solid);
+
+  glm::vec2 Position(unsigned int index) const { return glm::vec2(X[index], Y[index]); }
+  glm::vec2 Extent(unsigned int index) const { return glm::vec2(W[index], H[index]); }
+  bool IsSolid(unsigned int index) const { return SolidBits[index >> 6] >> (index & 63) & 1; }
+  bool IsDestroyed(unsigned int index) const { return DestroyedBits[index >> 6] >> (index & 63) & 1; }
+  void SetDestroyed(unsigned int index) { DestroyedBits[index >> 6] |= uint64_t(1) << (index & 63); }
+};
@@ -0,0 +1,73 @@
+#include "brick_instances.hpp"
+
+#include <cstddef>
+
+#include "render_state.hpp"
+
+BrickInstances::BrickInstances() : VAO(0), Count(0), quadVBO(0), instanceVBO(0) { }
+
+void BrickInstances::Generate(const std::vector<BrickInstance> &instances) {
+  if (VAO == 0) {
+    float vertices[] = {
+      // pos      // tex
+      0.0f, 1.0f, 0.0f, 1.0f,
+      1.0f, 0.0f, 1.0f, 0.0f,
+      0.0f, 0.0f, 0.0f, 0.0f,
+
+      0.0f, 1.0f, 0.0f, 1.0f,
+      1.0f, 1.0f, 1.0f, 1.0f,
+      1.0f, 0.0f, 1.0f, 0.0f
+    };
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &quadVBO);
+    glGenBuffers(1, &instanceVBO);
+
+    RenderState::BindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(BrickInstance), (void*)offsetof(BrickInstance, Position));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(BrickInstance), (void*)offsetof(BrickInstance, Size));
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(BrickInstance), (void*)offsetof(BrickInstance, Color));
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(BrickInstance), (void*)offsetof(BrickInstance, UV));
+    for (unsigned int i = 1; i <= 4; i++)
+      glVertexAttribDivisor(i, 1);
+
+    RenderState::BindVertexArray(0);
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+  // same layout as the last upload (a level reset): refill the existing storage
+  if (instances.size() == Count)
+    glBufferSubData(GL_ARRAY_BUFFER, 0, Count * sizeof(BrickInstance), instances.data());
+  else
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(BrickInstance), instances.data(), GL_DYNAMIC_DRAW);
+  Count = instances.size();
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void BrickInstances::Hide(unsigned int index) {
+  // a zero-sized instance rasterizes nothing, so a destroyed brick costs one tiny upload
+  glm::vec2 size(0.0f);
+  glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+  glBufferSubData(GL_ARRAY_BUFFER, index * sizeof(BrickInstance) + offsetof(BrickInstance, Size), sizeof(size), &size);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void BrickInstances::Delete() {
+  RenderState::ForgetVertexArray(VAO);
+  glDeleteVertexArrays(1, &VAO);
+  glDeleteBuffers(1, &quadVBO);
+  glDeleteBuffers(1, &instanceVBO);
+  VAO = quadVBO = instanceVBO = 0;
+  Count = 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+struct BrickInstance {
+  glm::vec2 Position;
+  glm::vec2 Size;
+  glm::vec3 Color;
+  glm::vec4 UV;
+};
+
+class BrickInstances {
+public:
+  unsigned int VAO;
+  unsigned int Count;
+
+  BrickInstances();
+
+  void Generate(const std::vector<BrickInstance> &instances);
+  void Hide(unsigned int index);
+  void Delete();
+
+private:
+  unsigned int quadVBO, instanceVBO;
+};
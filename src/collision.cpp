@@ -0,0 +1,195 @@
+#include "collision.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+static bool sweepCircleCorner(glm::vec2 center, float radius, glm::vec2 delta, glm::vec2 corner, SweepHit &hit) {
+  glm::vec2 m = center - corner;
+  float a = glm::dot(delta, delta);
+  float b = glm::dot(m, delta);
+  float c = glm::dot(m, m) - radius * radius;
+  if (a == 0.0f || b >= 0.0f)
+    return false;
+
+  float disc = b * b - a * c;
+  if (disc < 0.0f)
+    return false;
+
+  float t = (-b - std::sqrt(disc)) / a;
+  if (t < 0.0f || t > 1.0f)
+    return false;
+
+  hit.Time = t;
+  hit.Normal = glm::normalize(m + delta * t);
+  return true;
+}
+
+bool SweepCircleAABB(glm::vec2 center, float radius, glm::vec2 delta, glm::vec2 boxMin, glm::vec2 boxMax, SweepHit &hit) {
+  // already touching: only counts if the motion pushes further in
+  glm::vec2 closest = glm::clamp(center, boxMin, boxMax);
+  glm::vec2 offset = center - closest;
+  if (glm::dot(offset, offset) <= radius * radius) {
+    glm::vec2 normal;
+    if (offset != glm::vec2(0.0f)) {
+      normal = glm::normalize(offset);
+    }
+    else {
+      // center inside the box, push out along the shallowest axis
+      glm::vec2 toMin = center - boxMin, toMax = boxMax - center;
+      float dx = std::min(toMin.x, toMax.x), dy = std::min(toMin.y, toMax.y);
+      if (dx < dy)
+        normal = glm::vec2(toMin.x < toMax.x ? -1.0f : 1.0f, 0.0f);
+      else
+        normal = glm::vec2(0.0f, toMin.y < toMax.y ? -1.0f : 1.0f);
+    }
+    if (glm::dot(delta, normal) >= 0.0f)
+      return false;
+    hit.Time = 0.0f;
+    hit.Normal = normal;
+    return true;
+  }
+
+  // slab test of the center against the box grown by the radius
+  glm::vec2 grownMin = boxMin - radius, grownMax = boxMax + radius;
+  float tEnter = 0.0f, tExit = 1.0f;
+  glm::vec2 normal(0.0f);
+  for (int axis = 0; axis < 2; axis++) {
+    if (delta[axis] == 0.0f) {
+      if (center[axis] < grownMin[axis] || center[axis] > grownMax[axis])
+        return false;
+      continue;
+    }
+    float t0 = (grownMin[axis] - center[axis]) / delta[axis];
+    float t1 = (grownMax[axis] - center[axis]) / delta[axis];
+    float sign = -1.0f;
+    if (t0 > t1) {
+      std::swap(t0, t1);
+      sign = 1.0f;
+    }
+    if (t0 > tEnter) {
+      tEnter = t0;
+      normal = glm::vec2(0.0f);
+      normal[axis] = sign;
+    }
+    tExit = std::min(tExit, t1);
+    if (tEnter > tExit)
+      return false;
+  }
+  // no axis entered: the center starts inside the grown box but off the real one, i.e. in a
+  // corner region, where only the rounded corner can be hit
+  if (normal == glm::vec2(0.0f)) {
+    glm::vec2 corner(center.x < boxMin.x ? boxMin.x : boxMax.x, center.y < boxMin.y ? boxMin.y : boxMax.y);
+    return sweepCircleCorner(center, radius, delta, corner, hit);
+  }
+
+  // the grown box has square corners where the real shape is rounded
+  glm::vec2 p = center + delta * tEnter;
+  bool outsideX = p.x < boxMin.x || p.x > boxMax.x;
+  bool outsideY = p.y < boxMin.y || p.y > boxMax.y;
+  if (outsideX && outsideY) {
+    glm::vec2 corner(p.x < boxMin.x ? boxMin.x : boxMax.x, p.y < boxMin.y ? boxMin.y : boxMax.y);
+    return sweepCircleCorner(center, radius, delta, corner, hit);
+  }
+
+  hit.Time = tEnter;
+  hit.Normal = normal;
+  return true;
+}
+
+// same arithmetic as Game::CheckCollision, minus the sqrt
+static inline float distance2CircleAABB(float cx, float cy, float x, float y, float w, float h) {
+  float hw = w * 0.5f, hh = h * 0.5f;
+  float ax = x + hw, ay = y + hh;
+  float dx = ax + std::min(std::max(cx - ax, -hw), hw) - cx;
+  float dy = ay + std::min(std::max(cy - ay, -hh), hh) - cy;
+  return dx * dx + dy * dy;
+}
+
+#if defined(__SSE2__)
+// The build targets baseline SSE2; the AVX2 kernel is compiled for AVX2 on its own and only
+// called once the CPU reports it. Both fill d2 and mask for whole groups of lanes and return
+// where they stopped.
+__attribute__((target("avx2")))
+static unsigned int collideAVX2(glm::vec2 center, float r2, const float *x, const float *y, const float *w, const float *h, unsigned int count, float *d2, uint64_t &mask) {
+  const __m256 cx = _mm256_set1_ps(center.x), cy = _mm256_set1_ps(center.y);
+  const __m256 half = _mm256_set1_ps(0.5f), vr2 = _mm256_set1_ps(r2);
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 hw = _mm256_mul_ps(_mm256_loadu_ps(w + i), half);
+    __m256 hh = _mm256_mul_ps(_mm256_loadu_ps(h + i), half);
+    __m256 ax = _mm256_add_ps(_mm256_loadu_ps(x + i), hw);
+    __m256 ay = _mm256_add_ps(_mm256_loadu_ps(y + i), hh);
+    __m256 clampX = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(cx, ax), _mm256_sub_ps(_mm256_setzero_ps(), hw)), hw);
+    __m256 clampY = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(cy, ay), _mm256_sub_ps(_mm256_setzero_ps(), hh)), hh);
+    __m256 dx = _mm256_sub_ps(_mm256_add_ps(ax, clampX), cx);
+    __m256 dy = _mm256_sub_ps(_mm256_add_ps(ay, clampY), cy);
+    __m256 dist = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+    _mm256_storeu_ps(d2 + i, dist);
+    mask |= uint64_t(_mm256_movemask_ps(_mm256_cmp_ps(dist, vr2, _CMP_LE_OQ))) << i;
+  }
+  return i;
+}
+
+static unsigned int collideSSE2(glm::vec2 center, float r2, const float *x, const float *y, const float *w, const float *h, unsigned int i, unsigned int count, float *d2, uint64_t &mask) {
+  const __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y);
+  const __m128 half = _mm_set1_ps(0.5f), vr2 = _mm_set1_ps(r2);
+  for (; i + 4 <= count; i += 4) {
+    __m128 hw = _mm_mul_ps(_mm_loadu_ps(w + i), half);
+    __m128 hh = _mm_mul_ps(_mm_loadu_ps(h + i), half);
+    __m128 ax = _mm_add_ps(_mm_loadu_ps(x + i), hw);
+    __m128 ay = _mm_add_ps(_mm_loadu_ps(y + i), hh);
+    __m128 clampX = _mm_min_ps(_mm_max_ps(_mm_sub_ps(cx, ax), _mm_sub_ps(_mm_setzero_ps(), hw)), hw);
+    __m128 clampY = _mm_min_ps(_mm_max_ps(_mm_sub_ps(cy, ay), _mm_sub_ps(_mm_setzero_ps(), hh)), hh);
+    __m128 dx = _mm_sub_ps(_mm_add_ps(ax, clampX), cx);
+    __m128 dy = _mm_sub_ps(_mm_add_ps(ay, clampY), cy);
+    __m128 dist = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+    _mm_storeu_ps(d2 + i, dist);
+    mask |= uint64_t(_mm_movemask_ps(_mm_cmple_ps(dist, vr2))) << i;
+  }
+  return i;
+}
+#endif
+
+const char *CollisionKernel() {
+#if defined(__SSE2__)
+  return __builtin_cpu_supports("avx2") ? "avx2" : "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+CircleHits CollideCircleAABBs(glm::vec2 center, float radius, const float *x, const float *y, const float *w, const float *h, unsigned int count) {
+  CircleHits result = { 0, -1, 0.0f };
+  float r2 = radius * radius;
+  float d2[64];
+  unsigned int i = 0;
+  count = std::min(count, 64u);
+
+#if defined(__SSE2__)
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  if (avx2)
+    i = collideAVX2(center, r2, x, y, w, h, count, d2, result.Mask);
+  i = collideSSE2(center, r2, x, y, w, h, i, count, d2, result.Mask);
+#endif
+
+  // scalar tail, and the whole range when built without SIMD
+  for (; i < count; i++) {
+    d2[i] = distance2CircleAABB(center.x, center.y, x[i], y[i], w[i], h[i]);
+    if (d2[i] <= r2)
+      result.Mask |= uint64_t(1) << i;
+  }
+
+  for (uint64_t mask = result.Mask; mask != 0; mask &= mask - 1) {
+    int bit = __builtin_ctzll(mask);
+    if (result.Nearest < 0 || d2[bit] < result.NearestDistance2) {
+      result.Nearest = bit;
+      result.NearestDistance2 = d2[bit];
+    }
+  }
+  return result;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+struct SweepHit {
+  float Time;       // fraction of the motion in [0, 1] at first contact
+  glm::vec2 Normal; // surface normal at the contact, pointing towards the circle
+};
+
+// Earliest time of impact of a circle moving by delta against an AABB. Contacts the circle
+// is already separating from are ignored, so resting against a surface never re-triggers.
+bool SweepCircleAABB(glm::vec2 center, float radius, glm::vec2 delta, glm::vec2 boxMin, glm::vec2 boxMax, SweepHit &hit);
+
+struct CircleHits {
+  uint64_t Mask;          // bit i set when box i overlaps the circle
+  int Nearest;            // overlapping box whose closest point is nearest the center, -1 if none
+  float NearestDistance2;
+};
+
+// Tests a circle against up to 64 boxes stored as structure-of-arrays, several boxes per
+// instruction: 8 with AVX2 when the CPU has it, 4 with SSE2, the rest one at a time. A box
+// touching the circle counts, as in Game::CheckCollision; squared distances, so no sqrt.
+CircleHits CollideCircleAABBs(glm::vec2 center, float radius, const float *x, const float *y, const float *w, const float *h, unsigned int count);
+// the widest path CollideCircleAABBs takes on this machine: "avx2", "sse2" or "scalar"
+const char *CollisionKernel();
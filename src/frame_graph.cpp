@@ -0,0 +1,85 @@
+#include "frame_graph.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "render_state.hpp"
+
+// 3x5 glyphs for "0123456789.", one bit per pixel, the top row in bits 14-12
+static const unsigned short DIGITS[11] = {
+  075557, 026227, 071747, 071717, 055711, 074717, 074757, 071111, 075757, 075717, 000002,
+};
+
+FrameGraph::FrameGraph(const std::vector<glm::vec3> &colors) : colors(colors), samples(HISTORY * colors.size(), 0.0f), cursor(0), count(0) {
+  const unsigned char texels[8] = { 255, 255, 255, 255, 255, 255, 255, 128 };
+  solid.Internal_Format = GL_RGBA;
+  solid.Image_Format = GL_RGBA;
+  solid.Wrap_S = GL_CLAMP_TO_EDGE;
+  solid.Wrap_T = GL_CLAMP_TO_EDGE;
+  solid.Filter_Min = GL_NEAREST;
+  solid.Filter_Mag = GL_NEAREST;
+  solid.Generate(2, 1, texels);
+
+  shade = solid;
+  solid.UV = glm::vec4(0.25f, 0.5f, 0.25f, 0.5f);
+  shade.UV = glm::vec4(0.75f, 0.5f, 0.75f, 0.5f);
+}
+
+FrameGraph::~FrameGraph() {
+  RenderState::ForgetTexture(solid.ID);
+  glDeleteTextures(1, &solid.ID);
+}
+
+void FrameGraph::Push(const float *milliseconds) {
+  std::copy(milliseconds, milliseconds + colors.size(), samples.begin() + cursor * colors.size());
+  cursor = (cursor + 1) % HISTORY;
+  count = std::min(count + 1, HISTORY);
+}
+
+void FrameGraph::Draw(SpriteRenderer &renderer, glm::vec2 position, glm::vec2 size) {
+  unsigned int series = colors.size();
+
+  // the scale follows the slowest frame on screen, so a spike is obvious without clipping
+  float scale = 1.0f;
+  for (unsigned int row = 0; row < HISTORY; row++) {
+    float total = 0.0f;
+    for (unsigned int s = 0; s < series; s++)
+      total += samples[row * series + s];
+    scale = std::max(scale, total);
+  }
+
+  renderer.Submit(shade, position, size, 0.0f, glm::vec3(0.0f));
+
+  float column = size.x / HISTORY;
+  for (unsigned int i = 0; i < count; i++) {
+    unsigned int row = (cursor + HISTORY - count + i) % HISTORY;
+    float x = position.x + (HISTORY - count + i) * column;
+    float y = position.y + size.y;
+    for (unsigned int s = 0; s < series; s++) {
+      float height = samples[row * series + s] / scale * size.y;
+      if (height <= 0.0f)
+        continue;
+      y -= height;
+      renderer.Submit(solid, glm::vec2(x, y), glm::vec2(column, height), 0.0f, colors[s]);
+    }
+  }
+
+  const float PIXEL = 2.0f;
+  drawNumber(renderer, scale, position + glm::vec2(PIXEL), PIXEL, glm::vec3(1.0f));
+  unsigned int latest = (cursor + HISTORY - 1) % HISTORY;
+  for (unsigned int s = 0; s < series; s++)
+    drawNumber(renderer, samples[latest * series + s], position + glm::vec2(size.x + 3.0f * PIXEL, s * 7.0f * PIXEL), PIXEL, colors[s]);
+}
+
+void FrameGraph::drawNumber(SpriteRenderer &renderer, float value, glm::vec2 position, float pixel, glm::vec3 color) {
+  char text[16];
+  std::snprintf(text, sizeof(text), "%.2f", value);
+  for (const char *c = text; *c; c++) {
+    unsigned short glyph = *c == '.' ? DIGITS[10] : (*c >= '0' && *c <= '9') ? DIGITS[*c - '0'] : 0;
+    for (unsigned int bit = 0; bit < 15; bit++) {
+      if (glyph & (1 << (14 - bit)))
+        renderer.Submit(solid, position + glm::vec2(bit % 3, bit / 3) * pixel, glm::vec2(pixel), 0.0f, color);
+    }
+    position.x += 4.0f * pixel;
+  }
+}
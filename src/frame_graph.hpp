@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "sprite_renderer.hpp"
+#include "texture.hpp"
+
+// Rolling stacked-bar graph of per-frame timings, drawn through the sprite batch: one column per
+// frame, one coloured segment per series, the scale and the latest values printed beside it in a
+// built-in 3x5 pixel font.
+class FrameGraph {
+public:
+  static const unsigned int HISTORY = 240;
+
+  FrameGraph(const std::vector<glm::vec3> &colors);
+  ~FrameGraph();
+
+  FrameGraph(const FrameGraph &) = delete;
+  FrameGraph &operator=(const FrameGraph &) = delete;
+
+  // one value per series
+  void Push(const float *milliseconds);
+  void Draw(SpriteRenderer &renderer, glm::vec2 position, glm::vec2 size);
+
+private:
+  std::vector<glm::vec3> colors;
+  // HISTORY rows of one value per series, oldest overwritten first
+  std::vector<float> samples;
+  unsigned int cursor, count;
+  // both sample one 2x1 texture: an opaque and a half transparent white texel
+  Texture2D solid, shade;
+
+  void drawNumber(SpriteRenderer &renderer, float value, glm::vec2 position, float pixel, glm::vec3 color);
+};
@@ -2,8 +2,15 @@
 
 #include "sprite_renderer.hpp"
 #include "resource_manager.hpp"
+#include "collision.hpp"
+#include "hash.hpp"
+#include "profiler.hpp"
+#include "gpu_timer.hpp"
+#include "frame_graph.hpp"
 
-SpriteRenderer *Renderer;
+SpriteRenderer *Renderer = nullptr;
+LevelView *Bricks = nullptr;
+TextureHandle BackgroundTexture, BrickTexture;
 
 const glm::vec2 PLAYER_SIZE(100.0f, 20.0f);
 const float PLAYER_VELOCITY(500.0f);
@@ -13,29 +20,78 @@ const glm::vec2 INITIAL_BALL_VELOCITY(100.0f, -350.0f);
 const float BALL_RADIUS = 12.5f;
 BallObject *Ball;
 
-Game::Game(unsigned int width, unsigned int height) : State(GAME_ACTIVE), Keys(), Width(width), Height(height) {
+// positions at the start of the current tick, for render interpolation
+glm::vec2 PrevPlayerPosition, PrevBallPosition;
+
+// frame-time overlay: CPU tick/render time and GPU time per render pass
+enum RenderPass { PASS_BACKGROUND, PASS_BRICKS, PASS_PADDLE, PASS_BALL, PASS_COUNT };
+GpuTimer *PassTimer = nullptr;
+FrameGraph *CpuGraph = nullptr, *GpuGraph = nullptr;
+// CPU milliseconds in Tick so far (simulation side), up to the last drawn snapshot and in the
+// last Render (render side)
+double TickMilliseconds = 0.0, DrawnTickMilliseconds = 0.0;
+float RenderMilliseconds = 0.0f;
+
+Game::Game(unsigned int width, unsigned int height) : State(GAME_ACTIVE), Keys(), Width(width), Height(height), Level(0), ContinuousCollision(false), ShowOverlay(false) {
   
 }
 
 Game::~Game() {
+  Clear();
+}
+
+void Game::Clear() {
   delete Renderer;
+  delete Bricks;
+  delete PassTimer;
+  delete CpuGraph;
+  delete GpuGraph;
+  Renderer = nullptr;
+  Bricks = nullptr;
+  PassTimer = nullptr;
+  CpuGraph = GpuGraph = nullptr;
 }
 
 
 void Game::Init() {
-  ResourceManager::LoadShader("shaders/sprite.vert", "shaders/sprite.frag", "sprite");
-
-  glm::mat4 proj = glm::ortho(0.0f, static_cast<float>(Width), static_cast<float>(Height), 0.0f, -1.0f, 1.0f);
-  ResourceManager::GetShader("sprite").Use().SetInteger("image", 0);
-  ResourceManager::GetShader("sprite").SetMat4("projection", proj);
-
-  Renderer = new SpriteRenderer(ResourceManager::GetShader("sprite"));
+  PROFILE_ZONE("Game::Init");
+  // Init may run again, e.g. once per benchmark session; start from a clean slate
+  Clear();
+  delete Player;
+  delete Ball;
+  Levels.clear();
+  State = GAME_ACTIVE;
+
+  // the background decodes on the worker pool while the shaders compile
+  BackgroundTexture = ResourceManager::LoadTexturesAsync({
+    { "textures/background.jpg", false, "background" },
+  })[0];
+
+  ShaderHandle sprite = ResourceManager::LoadShader("shaders/sprite.vert", "shaders/sprite.frag", "sprite");
+  ShaderHandle brick = ResourceManager::LoadShader("shaders/brick.vert", "shaders/brick.frag", "brick");
+
+  if (!ResourceManager::Headless) {
+    glm::mat4 proj = glm::ortho(0.0f, static_cast<float>(Width), static_cast<float>(Height), 0.0f, -1.0f, 1.0f);
+    ResourceManager::Get(sprite).Use().SetInteger("image", 0);
+    ResourceManager::Get(sprite).SetMat4("projection", proj);
+    ResourceManager::Get(brick).Use().SetInteger("image", 0);
+    ResourceManager::Get(brick).SetMat4("projection", proj);
+
+    Renderer = new SpriteRenderer(ResourceManager::Get(sprite), ResourceManager::Get(brick));
+    Bricks = new LevelView();
+    PassTimer = new GpuTimer(PASS_COUNT);
+    CpuGraph = new FrameGraph({ glm::vec3(0.3f, 0.8f, 1.0f), glm::vec3(1.0f, 0.8f, 0.2f) });
+    GpuGraph = new FrameGraph({ glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(1.0f, 0.4f, 0.3f), glm::vec3(0.4f, 1.0f, 0.4f), glm::vec3(0.8f, 0.5f, 1.0f) });
+  }
 
-  ResourceManager::LoadTexture("textures/background.jpg", false, "background");
-  ResourceManager::LoadTexture("textures/awesomeface.png", true, "face");
-  ResourceManager::LoadTexture("textures/block.png", false, "block");
-  ResourceManager::LoadTexture("textures/block_solid.png", false, "block_solid");
-  ResourceManager::LoadTexture("textures/paddle.png", true, "paddle");
+  ResourceManager::LoadAtlas({
+    { "textures/awesomeface.png", "face" },
+    { "textures/block.png", "block" },
+    { "textures/block_solid.png", "block_solid" },
+    { "textures/paddle.png", "paddle" },
+  }, "sprites");
+  ResourceManager::WaitTextures();
+  BrickTexture = ResourceManager::FindTexture("block");
 
   GameLevel one; one.Load("levels/one.lvl", Width, Height / 2);
   GameLevel two; two.Load("levels/two.lvl", Width, Height / 2);
@@ -54,11 +110,55 @@ void Game::Init() {
 
   glm::vec2 ballPos = playerPos + glm::vec2(PLAYER_SIZE.x / 2.0f - BALL_RADIUS, -BALL_RADIUS * 2.0f);
   Ball = new BallObject(ballPos, BALL_RADIUS, INITIAL_BALL_VELOCITY, ResourceManager::GetTexture("face"));
+
+  PrevPlayerPosition = Player->Position;
+  PrevBallPosition = Ball->Position;
+  TickMilliseconds = DrawnTickMilliseconds = 0.0;
+  publish(0.0f);
+}
+
+void Game::Tick(float dt) {
+  PROFILE_ZONE("Game::Tick");
+  bool timed = ShowOverlay.load(std::memory_order_relaxed);
+  uint64_t begin = timed ? Profiler::Now() : 0;
+  PrevPlayerPosition = Player->Position;
+  PrevBallPosition = Ball->Position;
+
+  ProcessInput(dt);
+  Update(dt);
+  if (timed)
+    TickMilliseconds += (Profiler::Now() - begin) / 1e6;
+  publish(dt);
+}
+
+void Game::publish(float dt) {
+  FrameSnapshot &snapshot = Snapshots.Back();
+  const GameLevel &level = Levels[Level];
+  snapshot.State = State;
+  snapshot.PrevPlayerPosition = PrevPlayerPosition;
+  snapshot.PlayerPosition = Player->Position;
+  snapshot.PrevBallPosition = PrevBallPosition;
+  snapshot.BallPosition = Ball->Position;
+  snapshot.Bricks = level.Layout();
+  // the slot's capacity is reused, so this only allocates while a level's bit set grows
+  snapshot.DestroyedBits.assign(level.Bricks.DestroyedBits.begin(), level.Bricks.DestroyedBits.end());
+  snapshot.Time = Profiler::Now();
+  snapshot.Step = dt;
+  snapshot.TickMilliseconds = TickMilliseconds;
+  Snapshots.Publish();
 }
 
 void Game::Update(float dt) {
-  Ball->Move(dt, Width);
-  DoCollisions();
+  PROFILE_ZONE("Game::Update");
+  Levels[Level].Update(dt);
+  Levels[Level].Stream(Ball->Position + Ball->Radius);
+  if (ContinuousCollision) {
+    moveBallContinuous(dt);
+  }
+  else {
+    Ball->Move(dt, Width);
+    DoCollisions();
+  }
 
   if (Ball->Position.y >= Height) {
     ResetLevel();
@@ -66,32 +166,36 @@ void Game::Update(float dt) {
   }
 }
 
+uint64_t Game::StateHash() const {
+  const GameLevel &level = Levels[Level];
+  LevelStats stats = level.Stats();
+
+  uint64_t hash = HashBytes(&State, sizeof(State));
+  hash = HashBytes(&Level, sizeof(Level), hash);
+  hash = HashBytes(&Player->Position, sizeof(Player->Position), hash);
+  hash = HashBytes(&Ball->Position, sizeof(Ball->Position), hash);
+  hash = HashBytes(&Ball->Velocity, sizeof(Ball->Velocity), hash);
+  hash = HashBytes(&Ball->Stuck, sizeof(Ball->Stuck), hash);
+  hash = HashBytes(&stats.BricksRemaining, sizeof(stats.BricksRemaining), hash);
+  return HashBytes(level.Bricks.DestroyedBits.data(), level.Bricks.DestroyedBits.size() * sizeof(uint64_t), hash);
+}
+
 void Game::ResetLevel() {
-  std::string file;
-  switch (Level) {
-    case 0:
-      file = "levels/one.lvl";
-      break;
-    case 1:
-      file = "levels/two.lvl";
-      break;
-    case 2:
-      file = "levels/three.lvl";
-      break;
-    case 3:
-      file = "levels/four.lvl";
-      break;
-  }
-  Levels[Level].Load(file.c_str(), Width, Height / 2);
+  Levels[Level].Reset();
 }
 
 void Game::ResetPlayer() {
   Player->Position = glm::vec2(Width / 2.0f - PLAYER_SIZE.x / 2.0f, Height - PLAYER_SIZE.y);
   Ball->Stuck = true;
   Ball->Position = Player->Position + glm::vec2(PLAYER_SIZE.x / 2.0f - BALL_RADIUS, -BALL_RADIUS * 2.0f);
+
+  // a reset is a teleport, don't interpolate across it
+  PrevPlayerPosition = Player->Position;
+  PrevBallPosition = Ball->Position;
 }
 
 void Game::ProcessInput(float dt) {
+  PROFILE_ZONE("Game::ProcessInput");
   if (State == GAME_ACTIVE) {
     float velocity = PLAYER_VELOCITY * dt;
 
@@ -114,70 +218,233 @@ void Game::ProcessInput(float dt) {
   }
 }
 
+// ends the running timed pass and starts the next one (none if pass < 0); the batch is drawn
+// first so its sprites count towards the pass that submitted them
+static void switchPass(bool timed, int pass) {
+  if (!timed)
+    return;
+  Renderer->Flush();
+  PassTimer->End();
+  if (pass >= 0)
+    PassTimer->Begin(pass);
+}
+
 void Game::Render() {
-  if (State == GAME_ACTIVE) {
-    Renderer->DrawSprite(ResourceManager::GetTexture("background"), glm::vec2(0.0f, 0.0f), glm::vec2(Width, Height));
-    Levels[Level].Draw(*Renderer);
-    Player->Draw(*Renderer);
-    Ball->Draw(*Renderer);
+  PROFILE_ZONE("Game::Render");
+  // headless runs have no renderer
+  if (!Renderer)
+    return;
+  Snapshots.Acquire();
+  const FrameSnapshot &snapshot = Snapshots.Front();
+  if (snapshot.State != GAME_ACTIVE)
+    return;
+
+  uint64_t begin = Profiler::Now();
+  // the snapshot is drawn one step late, blended towards its end by how long ago it was published
+  float alpha = snapshot.Step > 0.0f ? glm::clamp((begin - snapshot.Time) / 1e9f / snapshot.Step, 0.0f, 1.0f) : 1.0f;
+  // paddle and ball would share one draw; splitting them only pays off while someone looks
+  bool timed = ShowOverlay;
+  if (timed)
+    PassTimer->BeginFrame();
+
+  // GPU instance updates happen here, on the render thread, never in the simulation
+  Bricks->Sync(snapshot.Bricks, snapshot.DestroyedBits);
+
+  // only positions change after Init, the rest of the paddle and ball is safe to read here
+  Renderer->Begin();
+  switchPass(timed, PASS_BACKGROUND);
+  Renderer->Submit(ResourceManager::Get(BackgroundTexture), glm::vec2(0.0f, 0.0f), glm::vec2(Width, Height));
+  switchPass(timed, PASS_BRICKS);
+  Bricks->Draw(*Renderer, ResourceManager::Get(BrickTexture));
+  switchPass(timed, PASS_PADDLE);
+  Renderer->Submit(Player->Sprite, glm::mix(snapshot.PrevPlayerPosition, snapshot.PlayerPosition, alpha), Player->Size, Player->Rotation, Player->Color);
+  switchPass(timed, PASS_BALL);
+  Renderer->Submit(Ball->Sprite, glm::mix(snapshot.PrevBallPosition, snapshot.BallPosition, alpha), Ball->Size, Ball->Rotation, Ball->Color);
+  switchPass(timed, -1);
+
+  if (timed) {
+    float cpu[2] = { static_cast<float>(snapshot.TickMilliseconds - DrawnTickMilliseconds), RenderMilliseconds };
+    float gpu[PASS_COUNT];
+    for (unsigned int pass = 0; pass < PASS_COUNT; pass++)
+      gpu[pass] = PassTimer->Milliseconds(pass);
+    CpuGraph->Push(cpu);
+    GpuGraph->Push(gpu);
+
+    glm::vec2 size(FrameGraph::HISTORY, 60.0f);
+    CpuGraph->Draw(*Renderer, glm::vec2(10.0f, 10.0f), size);
+    GpuGraph->Draw(*Renderer, glm::vec2(10.0f, 20.0f + size.y), size);
   }
+  DrawnTickMilliseconds = snapshot.TickMilliseconds;
+  Renderer->End();
+  // CPU side of this frame; it shows up in the graph with the next one
+  RenderMilliseconds = (Profiler::Now() - begin) / 1e6f;
 }
 
 void Game::DoCollisions() {
+  PROFILE_ZONE("Game::DoCollisions");
   // brick collisions
-  for (GameObject &box : Levels[Level].Bricks) {
-    if (!box.Destroyed) {
-      Collision collision = CheckCollision(*Ball, box);
-      if (std::get<0>(collision)) {
-        if (!box.IsSolid)
-          box.Destroyed = true;
-
-        Direction dir = std::get<1>(collision);
-        glm::vec2 diff_vector = std::get<2>(collision);
-        if (dir == LEFT || dir == RIGHT) {
-          Ball->Velocity.x = -Ball->Velocity.x;
-
-          float penetration = Ball->Radius - std::abs(diff_vector.x);
-
-          if (dir == LEFT)
-            Ball->Position.x += penetration;
-          else
-            Ball->Position.x -= penetration;
+  // only the tiles under the ball's swept box this tick can be hit; pad by a radius for the push-out
+  GameLevel &level = Levels[Level];
+  glm::vec2 sweepMin = glm::min(PrevBallPosition, Ball->Position) - Ball->Radius;
+  glm::vec2 sweepMax = glm::max(PrevBallPosition, Ball->Position) + Ball->Size + Ball->Radius;
+  spans.clear();
+  level.Query(sweepMin, sweepMax, spans);
+
+  const BrickArray &bricks = level.Bricks;
+  for (const BrickSpan &span : spans) {
+    unsigned int begin = span.Begin;
+    while (begin < span.End) {
+      // the kernel only filters: hits are confirmed by CheckCollision, so the radius is padded
+      // to never reject a brick the exact test would accept
+      unsigned int count = std::min(span.End - begin, 64u);
+      CircleHits hits = CollideCircleAABBs(Ball->Position + Ball->Radius, Ball->Radius * 1.0001f,
+        &bricks.X[begin], &bricks.Y[begin], &bricks.W[begin], &bricks.H[begin], count);
+
+      int hit = -1;
+      Collision collision;
+      for (uint64_t mask = hits.Mask; mask != 0; mask &= mask - 1) {
+        unsigned int candidate = begin + __builtin_ctzll(mask);
+        if (bricks.IsDestroyed(candidate))
+          continue;
+        collision = CheckCollision(*Ball, bricks.Position(candidate), bricks.Extent(candidate));
+        if (std::get<0>(collision)) {
+          hit = candidate;
+          break;
         }
-        else {
-          Ball->Velocity.y = -Ball->Velocity.y;
+      }
+      if (hit < 0) {
+        begin += count;
+        continue;
+      }
+      // resolving moves the ball, so the rest of the span is tested again from the new position
+      begin = hit + 1;
 
-          float penetration = Ball->Radius - std::abs(diff_vector.y);
+      if (!bricks.IsSolid(hit))
+        level.DestroyBrick(hit);
 
-          if (dir == UP)
-            Ball->Position.y -= penetration;
-          else
-            Ball->Position.y += penetration;
-        }
+      Direction dir = std::get<1>(collision);
+      glm::vec2 diff_vector = std::get<2>(collision);
+      if (dir == LEFT || dir == RIGHT) {
+        Ball->Velocity.x = -Ball->Velocity.x;
+
+        float penetration = Ball->Radius - std::abs(diff_vector.x);
+
+        if (dir == LEFT)
+          Ball->Position.x += penetration;
+        else
+          Ball->Position.x -= penetration;
+      }
+      else {
+        Ball->Velocity.y = -Ball->Velocity.y;
+
+        float penetration = Ball->Radius - std::abs(diff_vector.y);
+
+        if (dir == UP)
+          Ball->Position.y -= penetration;
+        else
+          Ball->Position.y += penetration;
       }
     }
   }
 
   // player collisions
   Collision result = CheckCollision(*Ball, *Player);
-  if (!Ball->Stuck && std::get<0>(result)) {
-    float centerBoard = Player->Position.x + Player->Size.x / 2.0f;
-    float distance = (Ball->Position.x + Ball->Radius) - centerBoard;
-    float percentage = distance / (Player->Size.x / 2.0f);
-
-    float strength = 2.0f;
-    glm::vec2 oldVelocity = Ball->Velocity;
-    Ball->Velocity.x = INITIAL_BALL_VELOCITY.x * percentage * strength;
-    Ball->Velocity.y = -1.0f * std::abs(Ball->Velocity.y);
-    Ball->Velocity = glm::normalize(Ball->Velocity) * glm::length(oldVelocity);
+  if (!Ball->Stuck && std::get<0>(result))
+    bounceOffPlayer();
+}
+
+void Game::bounceOffPlayer() {
+  float centerBoard = Player->Position.x + Player->Size.x / 2.0f;
+  float distance = (Ball->Position.x + Ball->Radius) - centerBoard;
+  float percentage = distance / (Player->Size.x / 2.0f);
+
+  float strength = 2.0f;
+  glm::vec2 oldVelocity = Ball->Velocity;
+  Ball->Velocity.x = INITIAL_BALL_VELOCITY.x * percentage * strength;
+  Ball->Velocity.y = -1.0f * std::abs(Ball->Velocity.y);
+  Ball->Velocity = glm::normalize(Ball->Velocity) * glm::length(oldVelocity);
+}
+
+void Game::moveBallContinuous(float dt) {
+  PROFILE_ZONE("Game::moveBallContinuous");
+  // bounces resolved per step; more would only happen if the ball got wedged
+  const unsigned int MAX_BOUNCES = 8;
+
+  if (Ball->Stuck)
+    return;
+
+  // the side and top walls as boxes reaching far outside the playfield
+  const float w = static_cast<float>(Width), h = static_cast<float>(Height);
+  const glm::vec2 walls[3][2] = {
+    { glm::vec2(-w, -h), glm::vec2(0.0f, 2.0f * h) },
+    { glm::vec2(w, -h), glm::vec2(2.0f * w, 2.0f * h) },
+    { glm::vec2(-w, -h), glm::vec2(2.0f * w, 0.0f) },
+  };
+
+  GameLevel &level = Levels[Level];
+  float remaining = 1.0f;
+  for (unsigned int bounce = 0; bounce < MAX_BOUNCES && remaining > 0.0f; bounce++) {
+    glm::vec2 center = Ball->Position + Ball->Radius;
+    glm::vec2 delta = Ball->Velocity * dt * remaining;
+
+    SweepHit best = { 2.0f, glm::vec2(0.0f) };
+    int brick = -1;
+    bool player = false;
+    SweepHit hit;
+
+    for (const auto &wall : walls) {
+      if (SweepCircleAABB(center, Ball->Radius, delta, wall[0], wall[1], hit) && hit.Time < best.Time)
+        best = hit;
+    }
+
+    spans.clear();
+    level.Query(glm::min(center, center + delta) - Ball->Radius, glm::max(center, center + delta) + Ball->Radius, spans);
+    for (const BrickSpan &span : spans) {
+      for (unsigned int i = span.Begin; i < span.End; i++) {
+        if (level.Bricks.IsDestroyed(i))
+          continue;
+        glm::vec2 boxMin = level.Bricks.Position(i);
+        if (SweepCircleAABB(center, Ball->Radius, delta, boxMin, boxMin + level.Bricks.Extent(i), hit) && hit.Time < best.Time) {
+          best = hit;
+          brick = i;
+        }
+      }
+    }
+
+    if (SweepCircleAABB(center, Ball->Radius, delta, Player->Position, Player->Position + Player->Size, hit) && hit.Time < best.Time) {
+      best = hit;
+      brick = -1;
+      player = true;
+    }
+
+    if (best.Time > 1.0f) {
+      Ball->Position += delta;
+      break;
+    }
+
+    Ball->Position += delta * best.Time;
+    remaining *= 1.0f - best.Time;
+
+    if (player) {
+      bounceOffPlayer();
+    }
+    else {
+      Ball->Velocity -= 2.0f * glm::dot(Ball->Velocity, best.Normal) * best.Normal;
+      if (brick >= 0 && !level.Bricks.IsSolid(brick))
+        level.DestroyBrick(brick);
+    }
   }
 }
 
 Collision Game::CheckCollision(BallObject &ball, GameObject &obj) {
+  return CheckCollision(ball, obj.Position, obj.Size);
+}
+
+Collision Game::CheckCollision(BallObject &ball, glm::vec2 position, glm::vec2 size) {
   glm::vec2 center(ball.Position + ball.Radius);
 
-  glm::vec2 aabb_half_extents(obj.Size / 2.0f);
-  glm::vec2 aabb_center(obj.Position + aabb_half_extents);
+  glm::vec2 aabb_half_extents(size / 2.0f);
+  glm::vec2 aabb_center(position + aabb_half_extents);
 
   glm::vec2 difference = center - aabb_center;
   glm::vec2 clamped = glm::clamp(difference, -aabb_half_extents, aabb_half_extents);
@@ -2,10 +2,13 @@
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <atomic>
+#include <memory>
 #include <tuple>
 
 #include "game_level.hpp"
 #include "ball_object.hpp"
+#include "triple_buffer.hpp"
 
 
 enum GameState {
@@ -23,6 +26,22 @@ enum Direction {
 
 typedef std::tuple<bool, Direction, glm::vec2> Collision;
 
+// What Render needs from one simulation step. Tick publishes one, Render draws the latest, so the
+// two can run on different threads without sharing any mutable state.
+struct FrameSnapshot {
+  GameState State;
+  // positions at the start and the end of the step, for interpolation
+  glm::vec2 PrevPlayerPosition, PlayerPosition;
+  glm::vec2 PrevBallPosition, BallPosition;
+  std::shared_ptr<const std::vector<BrickInstance>> Bricks;
+  std::vector<uint64_t> DestroyedBits;
+  // Profiler::Now() at publication and the step length, in seconds
+  uint64_t Time;
+  float Step;
+  // CPU time spent in Tick so far, counted only while the overlay is shown
+  double TickMilliseconds;
+};
+
 class Game {
   public:
     GameState State;
@@ -30,20 +49,38 @@ class Game {
     unsigned int Width, Height;
     std::vector<GameLevel> Levels;
     unsigned int Level;
+    // sweep the ball through each step instead of testing only where it ends up
+    bool ContinuousCollision;
+    // frame-time graphs: CPU tick and render, GPU time per render pass
+    std::atomic<bool> ShowOverlay;
+    TripleBuffer<FrameSnapshot> Snapshots;
 
     Game(unsigned int width, unsigned int height);
     ~Game();
 
     void Init();
+    // frees the renderer and its GL objects; call while the GL context is current
+    void Clear();
+    // one fixed simulation step: input followed by update, then a snapshot is published
+    void Tick(float dt);
     void ProcessInput(float dt);
     void Update(float dt);
+    // draws the latest snapshot, blending its two steps by how long ago it was published
     void Render();
     void DoCollisions();
+    // bit-exact digest of the simulation state; equal hashes mean a replay matched its recording
+    uint64_t StateHash() const;
 
   private:
+    std::vector<BrickSpan> spans;
+
     Collision CheckCollision(BallObject &ball, GameObject &obj);
+    Collision CheckCollision(BallObject &ball, glm::vec2 position, glm::vec2 size);
     void ResetLevel();
     void ResetPlayer();
+    void moveBallContinuous(float dt);
+    void bounceOffPlayer();
+    void publish(float dt);
 };
 
 Direction VectorDirection(glm::vec2 target);
@@ -1,64 +1,149 @@
 #include "game_level.hpp"
 
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <cmath>
 
 #include "resource_manager.hpp"
+#include "profiler.hpp"
 #include "sprite_renderer.hpp"
 
 void GameLevel::Load(const char *file, unsigned int levelWidth, unsigned int levelHeight) {
-  Bricks.clear();
-
-  unsigned int tileCode;
-  GameLevel level;
-  std::string line;
-  std::ifstream fstream(file);
-  std::vector<std::vector<unsigned int>> tileData;
-  
-  if (fstream) {
-    while (std::getline(fstream, line)) {
-      std::istringstream sstream(line);
-      std::vector<unsigned int> row;
-      while (sstream >> tileCode)
-        row.push_back(tileCode);
-      tileData.push_back(row);
-    }
-    if (tileData.size() > 0)
-      init(tileData, levelWidth, levelHeight);
+  PROFILE_ZONE("GameLevel::Load");
+  Bricks.Clear();
+  layout.reset();
+  firstBrick.clear();
+  gridX0 = gridY0 = 0;
+  gridWidth = gridHeight = 0;
+  liveBricks = destroyedBricks = 0;
+  elapsed = 0.0;
+  blockTexture = ResourceManager::FindTexture("block");
+  blockSolidTexture = ResourceManager::FindTexture("block_solid");
+
+  if (chunks.Open(file)) {
+    // nothing is built until the first Stream() call says where play happens
+    unitWidth = levelWidth / static_cast<float>(chunks.Width);
+    unitHeight = levelHeight / static_cast<float>(chunks.Height);
+    liveBricks = initialLiveBricks = chunks.Destructible;
+    return;
   }
+
+  if (LoadLevelFile(file, tiles))
+    init(tiles, levelWidth, levelHeight);
 }
 
-void GameLevel::Draw(SpriteRenderer &renderer) {
-  for (GameObject &tile : this->Bricks)
-    if (!tile.Destroyed)
-      tile.Draw(renderer);
+void GameLevel::Stream(glm::vec2 focus) {
+  if (!chunks.IsOpen())
+    return;
+
+  unsigned int size = chunks.ChunkSize;
+  int tileX = glm::clamp(static_cast<int>(std::floor(focus.x / unitWidth)), 0, static_cast<int>(chunks.Width) - 1);
+  int tileY = glm::clamp(static_cast<int>(std::floor(focus.y / unitHeight)), 0, static_cast<int>(chunks.Height) - 1);
+  unsigned int cx = tileX / size, cy = tileY / size;
+
+  unsigned int x0 = (cx > StreamRadius ? cx - StreamRadius : 0) * size;
+  unsigned int y0 = (cy > StreamRadius ? cy - StreamRadius : 0) * size;
+  unsigned int x1 = std::min((cx + StreamRadius + 1) * size, chunks.Width);
+  unsigned int y1 = std::min((cy + StreamRadius + 1) * size, chunks.Height);
+
+  if (chunks.Require(x0, y0, x1 - 1, y1 - 1)) {
+    PROFILE_ZONE("GameLevel::Stream");
+    LevelChunks &source = chunks;
+    buildBricks([&source](unsigned int x, unsigned int y) { return source.At(x, y); }, x0, y0, x1 - x0, y1 - y0);
+  }
+}
+
+void GameLevel::Reset() {
+  std::fill(Bricks.DestroyedBits.begin(), Bricks.DestroyedBits.end(), 0);
+  if (chunks.IsOpen())
+    chunks.ClearDestroyed();
+
+  liveBricks = initialLiveBricks;
+  destroyedBricks = 0;
+  elapsed = 0.0;
 }
 
 bool GameLevel::IsCompleted() {
-  for (GameObject &tile : this->Bricks)
-    if (!tile.IsSolid && !tile.Destroyed)
-      return false;
-  return true;
+  return liveBricks == 0;
+}
+
+void GameLevel::Update(float dt) {
+  elapsed += dt;
+}
+
+LevelStats GameLevel::Stats() const {
+  return { liveBricks, destroyedBricks, elapsed > 0.0 ? (float)(destroyedBricks / elapsed) : 0.0f };
+}
+
+void GameLevel::DestroyBrick(unsigned int index) {
+  if (Bricks.IsDestroyed(index))
+    return;
+  Bricks.SetDestroyed(index);
+  if (!Bricks.IsSolid(index))
+    liveBricks--;
+  destroyedBricks++;
+  if (chunks.IsOpen())
+    chunks.SetDestroyed(std::lround(Bricks.X[index] / unitWidth), std::lround(Bricks.Y[index] / unitHeight));
+}
+
+void GameLevel::Query(glm::vec2 min, glm::vec2 max, std::vector<BrickSpan> &spans) const {
+  if (gridWidth == 0 || max.x < 0.0f || max.y < 0.0f)
+    return;
+
+  int x0 = std::max(0, static_cast<int>(std::floor(min.x / unitWidth)) - static_cast<int>(gridX0));
+  int y0 = std::max(0, static_cast<int>(std::floor(min.y / unitHeight)) - static_cast<int>(gridY0));
+  int x1 = std::min(static_cast<int>(gridWidth) - 1, static_cast<int>(std::floor(max.x / unitWidth)) - static_cast<int>(gridX0));
+  int y1 = std::min(static_cast<int>(gridHeight) - 1, static_cast<int>(std::floor(max.y / unitHeight)) - static_cast<int>(gridY0));
+
+  if (x0 > x1)
+    return;
+  for (int y = y0; y <= y1; y++) {
+    BrickSpan span = { firstBrick[y * gridWidth + x0], firstBrick[y * gridWidth + x1 + 1] };
+    if (span.Begin != span.End)
+      spans.push_back(span);
+  }
+}
+
+void GameLevel::init(const LevelData &tileData, unsigned int lvlWidth, unsigned int lvlHeight) {
+  unitWidth = lvlWidth / static_cast<float>(tileData.Width);
+  unitHeight = lvlHeight / static_cast<float>(tileData.Height);
+
+  buildBricks([&tileData](unsigned int x, unsigned int y) { return tileData.At(x, y); }, 0, 0, tileData.Width, tileData.Height);
+
+  liveBricks = std::count_if(tileData.Tiles.begin(), tileData.Tiles.end(), [](uint8_t code) { return code > 1; });
+  initialLiveBricks = liveBricks;
 }
 
-void GameLevel::init(std::vector<std::vector<unsigned int>> tileData, unsigned int lvlWidth, unsigned int lvlHeight) {
-  unsigned int height = tileData.size();
-  unsigned int width = tileData[0].size();
-  float unit_width = lvlWidth / static_cast<float>(width);
-  float unit_height = lvlHeight / static_cast<float>(height);
+template <typename TileFn>
+void GameLevel::buildBricks(TileFn tileAt, unsigned int x0, unsigned int y0, unsigned int width, unsigned int height) {
+  gridX0 = x0;
+  gridY0 = y0;
+  gridWidth = width;
+  gridHeight = height;
+  firstBrick.assign(width * height + 1, 0);
+  Bricks.Clear();
+  // a fresh vector each time: the previous layout may still be drawn from
+  auto instanceData = std::make_shared<std::vector<BrickInstance>>();
+
+  const Texture2D &block = ResourceManager::Get(blockTexture);
+  const Texture2D &blockSolid = ResourceManager::Get(blockSolidTexture);
 
   for (unsigned int y = 0; y < height; y++) {
     for (unsigned int x = 0; x < width; x++) {
-      if (tileData[y][x] == 1) {
-        glm::vec2 pos(unit_width * x, unit_height * y);
-        glm::vec2 size(unit_width, unit_height);
-        GameObject obj(pos, size, ResourceManager::GetTexture("block_solid"), glm::vec3(0.8f, 0.8f, 0.7f));
-        obj.IsSolid = true;
-        Bricks.push_back(obj);
+      firstBrick[y * width + x] = Bricks.Count();
+
+      unsigned int code = tileAt(x0 + x, y0 + y);
+      if (code == 0)
+        continue;
+
+      glm::vec2 pos(unitWidth * (x0 + x), unitHeight * (y0 + y));
+      glm::vec2 size(unitWidth, unitHeight);
+      if (code == 1) {
+        Bricks.Add(pos, size, true);
+        instanceData->push_back({ pos, size, glm::vec3(0.8f, 0.8f, 0.7f), blockSolid.UV });
       }
-      else if (tileData[y][x] > 1) {
+      else {
         glm::vec3 color;
-        switch (tileData[y][x]) {
+        switch (code) {
           case 2:
             color = glm::vec3(0.2f, 0.6f, 1.0f);
             break;
@@ -75,11 +160,58 @@ void GameLevel::init(std::vector<std::vector<unsigned int>> tileData, unsigned i
             color = glm::vec3(1.0f);
             break;
         }
-
-        glm::vec2 pos(unit_width * x, unit_height * y);
-        glm::vec2 size(unit_width, unit_height);
-        Bricks.push_back(GameObject(pos, size, ResourceManager::GetTexture("block"), color));
+        Bricks.Add(pos, size, false);
+        instanceData->push_back({ pos, size, color, block.UV });
       }
+
+      // streamed chunks may come back after bricks on them were destroyed
+      if (chunks.IsOpen() && chunks.IsDestroyed(x0 + x, y0 + y))
+        Bricks.SetDestroyed(Bricks.Count() - 1);
+    }
+  }
+  firstBrick[width * height] = Bricks.Count();
+  layout = instanceData;
+}
+
+LevelView::~LevelView() {
+  instances.Delete();
+}
+
+void LevelView::Sync(const std::shared_ptr<const std::vector<BrickInstance>> &layout, const std::vector<uint64_t> &destroyedBits) {
+  bool restored = false;
+  for (unsigned int word = 0; word < destroyedBits.size() && word < this->destroyedBits.size(); word++)
+    restored |= (this->destroyedBits[word] & ~destroyedBits[word]) != 0;
+
+  // a new layout or bricks coming back (a level reset) need a full upload, anything else only
+  // hides the bricks destroyed since the last snapshot drawn
+  if (layout != this->layout || restored || destroyedBits.size() != this->destroyedBits.size()) {
+    this->layout = layout;
+    this->destroyedBits = destroyedBits;
+    rebuild();
+    return;
+  }
+
+  for (unsigned int word = 0; word < destroyedBits.size(); word++) {
+    for (uint64_t mask = destroyedBits[word] & ~this->destroyedBits[word]; mask != 0; mask &= mask - 1)
+      instances.Hide(word * 64 + __builtin_ctzll(mask));
+    this->destroyedBits[word] = destroyedBits[word];
+  }
+}
+
+void LevelView::Draw(SpriteRenderer &renderer, const Texture2D &texture) {
+  renderer.DrawInstanced(instances, texture);
+}
+
+void LevelView::rebuild() {
+  upload.clear();
+  if (layout)
+    upload.assign(layout->begin(), layout->end());
+  for (unsigned int word = 0; word < destroyedBits.size(); word++) {
+    for (uint64_t mask = destroyedBits[word]; mask != 0; mask &= mask - 1) {
+      unsigned int index = word * 64 + __builtin_ctzll(mask);
+      if (index < upload.size())
+        upload[index].Size = glm::vec2(0.0f);
     }
   }
+  instances.Generate(upload);
 }
@@ -1,22 +1,96 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "game_object.hpp"
 #include "sprite_renderer.hpp"
+#include "brick_instances.hpp"
+#include "brick_array.hpp"
+#include "level_data.hpp"
+#include "level_chunks.hpp"
+#include "resource_manager.hpp"
+
+// bricks [Begin, End) are contiguous in a level's BrickArray
+struct BrickSpan {
+  unsigned int Begin, End;
+};
+
+struct LevelStats {
+  unsigned int BricksRemaining;
+  unsigned int BricksDestroyed;
+  float DestroyedPerSecond;
+};
 
 class GameLevel {
 public:
-  std::vector<GameObject> Bricks;
+  BrickArray Bricks;
+  // chunked levels only: how many chunks around the focus chunk stay built
+  unsigned int StreamRadius = 1;
 
   GameLevel() {}
 
   void Load(const char * file, unsigned int levelWidth, unsigned int levelHeight);
+  // restores the level as loaded, without touching the file or allocating
+  void Reset();
+  // chunked levels only: rebuilds the bricks when the chunk window around focus changes
+  void Stream(glm::vec2 focus);
 
-  void Draw(SpriteRenderer &renderer);
+  // instance data of the bricks as built, destroyed ones included; never modified once built, so
+  // the render thread can hold on to it while the simulation moves on
+  const std::shared_ptr<const std::vector<BrickInstance>> &Layout() const { return layout; }
 
   bool IsCompleted();
 
+  // advances the level clock used for the destruction rate
+  void Update(float dt);
+  LevelStats Stats() const;
+
+  void DestroyBrick(unsigned int index);
+
+  // appends one span per tile row overlapping [min, max]; destroyed bricks are not filtered out
+  void Query(glm::vec2 min, glm::vec2 max, std::vector<BrickSpan> &spans) const;
+
+private:
+  // broadphase: bricks are created in row-major tile order, so firstBrick[tile] (the number of
+  // bricks on earlier tiles) turns any run of tiles in a row into a contiguous brick span
+  std::vector<unsigned int> firstBrick;
+  // the tiles covered by Bricks; the whole level unless it is streamed from chunks
+  unsigned int gridX0 = 0, gridY0 = 0;
+  unsigned int gridWidth = 0, gridHeight = 0;
+  float unitWidth = 0.0f, unitHeight = 0.0f;
+
+  std::shared_ptr<const std::vector<BrickInstance>> layout;
+
+  unsigned int liveBricks = 0;
+  unsigned int initialLiveBricks = 0;
+  unsigned int destroyedBricks = 0;
+  double elapsed = 0.0;
+
+  LevelData tiles;
+  LevelChunks chunks;
+  TextureHandle blockTexture, blockSolidTexture;
+
+  void init(const LevelData &tileData, unsigned int levelWidth, unsigned int levelHeight);
+  template <typename TileFn>
+  void buildBricks(TileFn tileAt, unsigned int x0, unsigned int y0, unsigned int width, unsigned int height);
+};
+
+// Render-thread side of a level: the GPU instances of a published layout, kept in step with the
+// destroyed bits of whichever snapshot is drawn
+class LevelView {
+public:
+  // needs the GL context that drew it
+  ~LevelView();
+
+  void Sync(const std::shared_ptr<const std::vector<BrickInstance>> &layout, const std::vector<uint64_t> &destroyedBits);
+  void Draw(SpriteRenderer &renderer, const Texture2D &texture);
+
 private:
-  void init(std::vector<std::vector<unsigned int>> tileData, unsigned int levelWidth, unsigned int levelHeight);
+  BrickInstances instances;
+  std::shared_ptr<const std::vector<BrickInstance>> layout;
+  std::vector<uint64_t> destroyedBits;
+  std::vector<BrickInstance> upload;
+
+  void rebuild();
 };
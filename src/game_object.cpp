@@ -6,5 +6,5 @@ GameObject::GameObject(glm::vec2 pos, glm::vec2 size, Texture2D sprite, glm::vec
   : Position(pos), Size(size), Velocity(velocity), Color(color), Rotation(0.0f), Sprite(sprite), IsSolid(false), Destroyed(false) {}
 
 void GameObject::Draw(SpriteRenderer &renderer) {
-  renderer.DrawSprite(this->Sprite, this->Position, this->Size, this->Rotation, this->Color);
+  renderer.Submit(this->Sprite, this->Position, this->Size, this->Rotation, this->Color);
 }
@@ -18,6 +18,7 @@ public:
 
   GameObject();
   GameObject(glm::vec2 pos, glm::vec2 size, Texture2D sprite, glm::vec3 color = glm::vec3(1.0f), glm::vec2 velocity = glm::vec2(0.0f, 0.0f));
+  virtual ~GameObject() { }
 
   virtual void Draw(SpriteRenderer &renderer);
 };
@@ -0,0 +1,49 @@
+#include "gpu_timer.hpp"
+
+#include <algorithm>
+
+GpuTimer::GpuTimer(unsigned int passes) : passes(std::min(passes, MAX_PASSES)), pending(), results(), frame(0), active(-1) {
+  for (unsigned int i = 0; i < FRAMES; i++)
+    glGenQueries(this->passes, queries[i]);
+}
+
+GpuTimer::~GpuTimer() {
+  for (unsigned int i = 0; i < FRAMES; i++)
+    glDeleteQueries(passes, queries[i]);
+}
+
+void GpuTimer::BeginFrame() {
+  frame = (frame + 1) % FRAMES;
+  for (unsigned int pass = 0; pass < passes; pass++) {
+    if (!pending[frame][pass])
+      continue;
+
+    int available = 0;
+    glGetQueryObjectiv(queries[frame][pass], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+      continue;
+
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(queries[frame][pass], GL_QUERY_RESULT, &nanoseconds);
+    results[pass] = nanoseconds / 1.0e6f;
+    pending[frame][pass] = false;
+  }
+}
+
+void GpuTimer::Begin(unsigned int pass) {
+  // a query the GPU hasn't answered yet can't be reused; this pass goes untimed for a frame
+  if (pass >= passes || pending[frame][pass])
+    return;
+
+  glBeginQuery(GL_TIME_ELAPSED, queries[frame][pass]);
+  active = pass;
+}
+
+void GpuTimer::End() {
+  if (active < 0)
+    return;
+
+  glEndQuery(GL_TIME_ELAPSED);
+  pending[frame][active] = true;
+  active = -1;
+}
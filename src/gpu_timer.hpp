@@ -0,0 +1,31 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// GL_TIME_ELAPSED per render pass. Every frame times into its own set of queries and a set is
+// only read back FRAMES frames later, once the driver reports it available, so timing never
+// stalls the pipeline. Passes can't nest: End() the running pass before the next Begin().
+class GpuTimer {
+public:
+  static const unsigned int MAX_PASSES = 8;
+  static const unsigned int FRAMES = 2;
+
+  GpuTimer(unsigned int passes);
+  ~GpuTimer();
+
+  // collects whatever finished from the set this frame is about to reuse
+  void BeginFrame();
+  void Begin(unsigned int pass);
+  void End();
+
+  // latest finished measurement of pass
+  float Milliseconds(unsigned int pass) const { return results[pass]; }
+
+private:
+  unsigned int passes;
+  unsigned int queries[FRAMES][MAX_PASSES];
+  bool pending[FRAMES][MAX_PASSES];
+  float results[MAX_PASSES];
+  unsigned int frame;
+  int active;
+};
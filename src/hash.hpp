@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+const uint64_t HASH_SEED = 14695981039346656037ull;
+
+// FNV-1a; names cache entries, not meant to resist collisions on purpose. Chain calls by
+// passing the previous result as the seed.
+inline uint64_t HashBytes(const void *data, size_t size, uint64_t hash = HASH_SEED) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < size; i++)
+    hash = (hash ^ bytes[i]) * 1099511628211ull;
+  return hash;
+}
@@ -0,0 +1,108 @@
+#include "input_replay.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+InputRecorder::InputRecorder() : step(0.0f), flags(0), ticks(0), lastChange(0), previous() { }
+
+void InputRecorder::Begin(float step, uint16_t flags) {
+  this->step = step;
+  this->flags = flags;
+  ticks = 0;
+  lastChange = 0;
+  std::memset(previous, 0, sizeof(previous));
+  events.clear();
+}
+
+void InputRecorder::Record(const bool *keys) {
+  // nearly every tick changes nothing
+  if (std::memcmp(keys, previous, sizeof(previous)) == 0) {
+    ticks++;
+    return;
+  }
+
+  for (unsigned int key = 0; key < REPLAY_KEYS; key++) {
+    if (keys[key] == previous[key])
+      continue;
+
+    uint64_t value = (uint64_t)(ticks - lastChange) << 11 | (uint64_t)keys[key] << 10 | key;
+    do {
+      events.push_back((value & 0x7f) | (value >= 0x80 ? 0x80 : 0));
+      value >>= 7;
+    } while (value != 0);
+
+    previous[key] = keys[key];
+    lastChange = ticks;
+  }
+  ticks++;
+}
+
+bool InputRecorder::Save(const char *file, uint64_t finalHash) const {
+  ReplayHeader header;
+  std::memcpy(header.Magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+  header.Version = REPLAY_VERSION;
+  header.Flags = flags;
+  header.Step = step;
+  header.Ticks = ticks;
+  header.FinalHash = finalHash;
+
+  std::ofstream out(file, std::ios::binary);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(events.data()), events.size());
+  if (!out) {
+    std::cerr << "Error: Failed to write replay " << file << "\n";
+    return false;
+  }
+  return true;
+}
+
+InputPlayer::InputPlayer() : Header(), cursor(0), tick(0), nextChange(0), nextEvent(0), hasEvent(false) { }
+
+bool InputPlayer::Load(const char *file) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in.read(reinterpret_cast<char *>(&Header), sizeof(Header))) {
+    std::cerr << "Error: Failed to read replay " << file << "\n";
+    return false;
+  }
+  if (std::memcmp(Header.Magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0 || Header.Version != REPLAY_VERSION || !(Header.Step > 0.0f)) {
+    std::cerr << "Error: " << file << " is not a version " << REPLAY_VERSION << " replay\n";
+    return false;
+  }
+
+  events.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  cursor = 0;
+  tick = 0;
+  nextChange = 0;
+  readEvent();
+  return true;
+}
+
+void InputPlayer::Apply(bool *keys) {
+  while (hasEvent && nextChange == tick) {
+    keys[nextEvent & 0x3ff] = (nextEvent >> 10) & 1;
+    readEvent();
+  }
+  tick++;
+}
+
+void InputPlayer::readEvent() {
+  uint64_t value = 0;
+  unsigned int shift = 0;
+  hasEvent = false;
+  while (cursor < events.size() && shift < 64) {
+    uint8_t byte = events[cursor++];
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    shift += 7;
+    if (!(byte & 0x80)) {
+      hasEvent = true;
+      break;
+    }
+  }
+  if (!hasEvent)
+    return;
+
+  nextChange += value >> 11;
+  nextEvent = value & 0x7ff;
+}
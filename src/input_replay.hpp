@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const unsigned int REPLAY_KEYS = 1024;
+
+// Replay files, host byte order: ReplayHeader, then one varint per key change. Each varint packs
+// (ticks since the previous change << 11) | (pressed << 10) | key, so holding a key costs nothing
+// and a typical tick costs no bytes at all.
+const char REPLAY_MAGIC[4] = { 'B', 'R', 'P', 'L' };
+const uint16_t REPLAY_VERSION = 1;
+// the recording ran with Game::ContinuousCollision
+const uint16_t REPLAY_FLAG_CCD = 1 << 0;
+
+struct ReplayHeader {
+  char Magic[4];
+  uint16_t Version;
+  uint16_t Flags;
+  // fixed simulation step the recording ran at
+  float Step;
+  uint32_t Ticks;
+  // Game::StateHash() after the last tick
+  uint64_t FinalHash;
+};
+
+// Logs Game::Keys once per fixed tick, right before the tick consumes them.
+class InputRecorder {
+public:
+  InputRecorder();
+
+  void Begin(float step, uint16_t flags);
+  void Record(const bool *keys);
+  bool Save(const char *file, uint64_t finalHash) const;
+  unsigned int Ticks() const { return ticks; }
+
+private:
+  float step;
+  uint16_t flags;
+  uint32_t ticks;
+  uint32_t lastChange;
+  bool previous[REPLAY_KEYS];
+  std::vector<uint8_t> events;
+};
+
+// Feeds a recording back, one tick at a time, into the same key array the window would fill.
+class InputPlayer {
+public:
+  ReplayHeader Header;
+
+  InputPlayer();
+
+  // errors go to std::cerr
+  bool Load(const char *file);
+  bool Done() const { return tick >= Header.Ticks; }
+  // applies every change recorded for the next tick
+  void Apply(bool *keys);
+
+private:
+  std::vector<uint8_t> events;
+  size_t cursor;
+  uint32_t tick;
+  uint32_t nextChange;
+  uint32_t nextEvent;
+  bool hasEvent;
+
+  void readEvent();
+};
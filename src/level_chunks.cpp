@@ -0,0 +1,246 @@
+#include "level_chunks.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool WriteLevelChunked(const char *file, const LevelData &level, unsigned int chunkSize) {
+  if (chunkSize == 0 || chunkSize > MAX_CHUNK_SIZE) {
+    std::cerr << "Error: Chunk size must be between 1 and " << MAX_CHUNK_SIZE << " tiles\n";
+    return false;
+  }
+
+  uint8_t indexOf[256];
+  bool used[256] = { };
+  for (uint8_t code : level.Tiles)
+    used[code] = true;
+  // padding tiles past the level edge are empty, code 0
+  if (level.Width % chunkSize || level.Height % chunkSize)
+    used[0] = true;
+
+  std::vector<uint8_t> palette;
+  for (unsigned int code = 0; code < 256; code++) {
+    if (used[code]) {
+      indexOf[code] = palette.size();
+      palette.push_back(code);
+    }
+  }
+
+  LevelChunkInfo info;
+  info.ChunkSize = chunkSize;
+  info.ChunksX = (level.Width + chunkSize - 1) / chunkSize;
+  info.ChunksY = (level.Height + chunkSize - 1) / chunkSize;
+  info.Destructible = std::count_if(level.Tiles.begin(), level.Tiles.end(), [](uint8_t code) { return code > 1; });
+
+  // chunks are always chunkSize square, tiles past the level edge are empty
+  std::vector<uint64_t> offsets;
+  std::vector<uint8_t> payload;
+  for (unsigned int cy = 0; cy < info.ChunksY; cy++) {
+    for (unsigned int cx = 0; cx < info.ChunksX; cx++) {
+      offsets.push_back(payload.size());
+      int runCode = -1;
+      unsigned int run = 0;
+      for (unsigned int y = cy * chunkSize; y < (cy + 1) * chunkSize; y++) {
+        for (unsigned int x = cx * chunkSize; x < (cx + 1) * chunkSize; x++) {
+          int code = (x < level.Width && y < level.Height) ? level.At(x, y) : 0;
+          if (code == runCode && run < 255) {
+            run++;
+            continue;
+          }
+          if (run > 0) {
+            payload.push_back(run);
+            payload.push_back(indexOf[runCode]);
+          }
+          runCode = code;
+          run = 1;
+        }
+      }
+      payload.push_back(run);
+      payload.push_back(indexOf[runCode]);
+    }
+  }
+  offsets.push_back(payload.size());
+
+  LevelFileHeader header;
+  std::memcpy(header.Magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC));
+  header.Version = LEVEL_VERSION_CHUNKED;
+  header.Flags = LEVEL_FLAG_RLE;
+  header.Width = level.Width;
+  header.Height = level.Height;
+  header.PaletteSize = palette.size();
+  header.PayloadSize = payload.size();
+
+  std::ofstream out(file, std::ios::binary);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(palette.data()), palette.size());
+  out.write(reinterpret_cast<const char *>(&info), sizeof(info));
+  out.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(uint64_t));
+  out.write(reinterpret_cast<const char *>(payload.data()), payload.size());
+  return static_cast<bool>(out);
+}
+
+LevelChunks::MappedFile::~MappedFile() {
+  munmap(const_cast<uint8_t *>(Data), Size);
+}
+
+LevelChunks::LevelChunks()
+  : Width(0), Height(0), ChunkSize(0), ChunksX(0), ChunksY(0), Destructible(0), BudgetBytes(4 << 20), ResidentBytes(0),
+    palette(nullptr), paletteSize(0), offsets(nullptr), payload(nullptr), payloadSize(0),
+    windowX0(1), windowY0(1), windowX1(0), windowY1(0), clock(0) { }
+
+bool LevelChunks::Open(const char *path) {
+  Close();
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  LevelFileHeader header;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(header) + sizeof(LevelChunkInfo) || read(fd, &header, sizeof(header)) != sizeof(header)
+      || std::memcmp(header.Magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC)) != 0 || header.Version != LEVEL_VERSION_CHUNKED) {
+    close(fd);
+    return false;
+  }
+
+  void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    std::cerr << "Error: Failed to map level " << path << "\n";
+    return false;
+  }
+  file = std::make_shared<MappedFile>(static_cast<const uint8_t *>(data), (size_t)st.st_size);
+
+  // every size below comes from the file; check each against the mapping before it is used
+  LevelChunkInfo info;
+  size_t tableOffset = sizeof(header) + (size_t)header.PaletteSize + sizeof(info);
+  size_t chunkCount = 0;
+  bool valid = header.PaletteSize > 0 && header.PaletteSize <= 256 && tableOffset <= file->Size;
+  if (valid) {
+    palette = file->Data + sizeof(header);
+    paletteSize = header.PaletteSize;
+    std::memcpy(&info, palette + paletteSize, sizeof(info));
+
+    // the chunks must cover the level, a chunk is decoded whole so it has to stay small, and the
+    // offset table and payload must fit in the file
+    chunkCount = (size_t)info.ChunksX * info.ChunksY;
+    valid = info.ChunkSize > 0 && info.ChunkSize <= MAX_CHUNK_SIZE && header.Width > 0 && header.Height > 0
+      && (uint64_t)info.ChunksX * info.ChunkSize >= header.Width && (uint64_t)info.ChunksY * info.ChunkSize >= header.Height
+      && chunkCount < (file->Size - tableOffset) / sizeof(uint64_t)
+      && header.PayloadSize <= file->Size - tableOffset - (chunkCount + 1) * sizeof(uint64_t);
+  }
+  if (!valid) {
+    std::cerr << "Error: Chunked level " << path << " is corrupt\n";
+    Close();
+    return false;
+  }
+  size_t payloadOffset = tableOffset + (chunkCount + 1) * sizeof(uint64_t);
+  offsets = file->Data + tableOffset;
+  payload = file->Data + payloadOffset;
+  payloadSize = header.PayloadSize;
+
+  Width = header.Width;
+  Height = header.Height;
+  ChunkSize = info.ChunkSize;
+  ChunksX = info.ChunksX;
+  ChunksY = info.ChunksY;
+  Destructible = info.Destructible;
+
+  chunks.assign(chunkCount, Chunk());
+  destroyed.assign(((size_t)Width * Height + 63) / 64, 0);
+  return true;
+}
+
+void LevelChunks::Close() {
+  file.reset();
+  chunks.clear();
+  destroyed.clear();
+  ResidentBytes = 0;
+  windowX0 = windowY0 = 1;
+  windowX1 = windowY1 = 0;
+}
+
+bool LevelChunks::Require(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1) {
+  unsigned int cx0 = x0 / ChunkSize, cy0 = y0 / ChunkSize;
+  unsigned int cx1 = std::min(x1 / ChunkSize, ChunksX - 1), cy1 = std::min(y1 / ChunkSize, ChunksY - 1);
+  if (cx0 == windowX0 && cy0 == windowY0 && cx1 == windowX1 && cy1 == windowY1)
+    return false;
+
+  windowX0 = cx0;
+  windowY0 = cy0;
+  windowX1 = cx1;
+  windowY1 = cy1;
+
+  clock++;
+  for (unsigned int cy = cy0; cy <= cy1; cy++) {
+    for (unsigned int cx = cx0; cx <= cx1; cx++) {
+      Chunk &chunk = chunks[cy * ChunksX + cx];
+      if (chunk.Tiles.empty())
+        decode(cy * ChunksX + cx);
+      chunk.LastUsed = clock;
+    }
+  }
+  evict();
+  return true;
+}
+
+uint8_t LevelChunks::At(unsigned int x, unsigned int y) const {
+  const Chunk &chunk = chunks[(y / ChunkSize) * ChunksX + x / ChunkSize];
+  return chunk.Tiles[(y % ChunkSize) * ChunkSize + x % ChunkSize];
+}
+
+bool LevelChunks::IsDestroyed(unsigned int x, unsigned int y) const {
+  size_t tile = (size_t)y * Width + x;
+  return destroyed[tile >> 6] >> (tile & 63) & 1;
+}
+
+void LevelChunks::SetDestroyed(unsigned int x, unsigned int y) {
+  size_t tile = (size_t)y * Width + x;
+  destroyed[tile >> 6] |= uint64_t(1) << (tile & 63);
+}
+
+void LevelChunks::ClearDestroyed() {
+  std::fill(destroyed.begin(), destroyed.end(), 0);
+}
+
+void LevelChunks::decode(unsigned int index) {
+  Chunk &chunk = chunks[index];
+  chunk.Tiles.assign(ChunkSize * ChunkSize, 0);
+
+  // the table isn't necessarily 8-byte aligned inside the file
+  uint64_t begin, end;
+  std::memcpy(&begin, offsets + index * sizeof(uint64_t), sizeof(begin));
+  std::memcpy(&end, offsets + (index + 1) * sizeof(uint64_t), sizeof(end));
+  end = std::min<uint64_t>(end, payloadSize);
+
+  size_t tile = 0;
+  for (uint64_t i = begin; i + 1 < end; i += 2) {
+    uint8_t run = payload[i], code = payload[i + 1] < paletteSize ? palette[payload[i + 1]] : 0;
+    run = std::min<size_t>(run, chunk.Tiles.size() - tile);
+    std::memset(&chunk.Tiles[tile], code, run);
+    tile += run;
+  }
+  ResidentBytes += chunk.Tiles.size();
+}
+
+void LevelChunks::evict() {
+  // the current window was just stamped with the newest clock value and is never evicted
+  while (ResidentBytes > BudgetBytes) {
+    Chunk *oldest = nullptr;
+    for (Chunk &chunk : chunks)
+      if (!chunk.Tiles.empty() && chunk.LastUsed != clock && (!oldest || chunk.LastUsed < oldest->LastUsed))
+        oldest = &chunk;
+    if (!oldest)
+      break;
+
+    ResidentBytes -= oldest->Tiles.size();
+    oldest->Tiles.clear();
+    oldest->Tiles.shrink_to_fit();
+  }
+}
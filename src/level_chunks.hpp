@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "level_data.hpp"
+
+// Chunked binary levels (LevelFileHeader.Version == LEVEL_VERSION_CHUNKED):
+//   LevelFileHeader, palette, LevelChunkInfo, uint64_t offsets[ChunksX * ChunksY + 1], payload
+// Each chunk is RLE-encoded on its own (see LEVEL_FLAG_RLE), offsets are relative to the payload.
+const uint16_t LEVEL_VERSION_CHUNKED = 2;
+const unsigned int MAX_CHUNK_SIZE = 4096;
+
+struct LevelChunkInfo {
+  uint32_t ChunkSize;
+  uint32_t ChunksX, ChunksY;
+  uint32_t Destructible;
+};
+
+bool WriteLevelChunked(const char *file, const LevelData &level, unsigned int chunkSize);
+
+// Streams a chunked level: chunks are decoded from the mapped file on demand and the least
+// recently used ones are evicted once the resident tiles exceed BudgetBytes. Destroyed tiles are
+// remembered for the whole level (one bit per tile) so eviction never resurrects bricks.
+class LevelChunks {
+public:
+  unsigned int Width, Height;
+  unsigned int ChunkSize;
+  unsigned int ChunksX, ChunksY;
+  unsigned int Destructible;
+  size_t BudgetBytes;
+  size_t ResidentBytes;
+
+  LevelChunks();
+
+  // false, without complaint, when the file is not a chunked level
+  bool Open(const char *file);
+  void Close();
+  bool IsOpen() const { return file != nullptr; }
+
+  // makes all chunks overlapping tiles [x0, x1] x [y0, y1] resident; true if the window moved
+  bool Require(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1);
+  // tile code, the chunk must be resident
+  uint8_t At(unsigned int x, unsigned int y) const;
+
+  bool IsDestroyed(unsigned int x, unsigned int y) const;
+  void SetDestroyed(unsigned int x, unsigned int y);
+  void ClearDestroyed();
+
+private:
+  struct Chunk {
+    std::vector<uint8_t> Tiles;
+    unsigned long LastUsed = 0;
+  };
+
+  struct MappedFile {
+    const uint8_t *Data;
+    size_t Size;
+    MappedFile(const uint8_t *data, size_t size) : Data(data), Size(size) { }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+  };
+
+  // read-only, so copies of a level share one mapping
+  std::shared_ptr<MappedFile> file;
+  const uint8_t *palette;
+  unsigned int paletteSize;
+  const uint8_t *offsets;
+  const uint8_t *payload;
+  uint64_t payloadSize;
+
+  std::vector<Chunk> chunks;
+  std::vector<uint64_t> destroyed;
+  unsigned int windowX0, windowY0, windowX1, windowY1;
+  unsigned long clock;
+
+  void decode(unsigned int index);
+  void evict();
+};
@@ -0,0 +1,208 @@
+#include "level_data.hpp"
+
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static bool fail(LevelError &error, unsigned int line, unsigned int column, const char *message) {
+  error.Line = line;
+  error.Column = column;
+  error.Message = message;
+  return false;
+}
+
+bool ParseLevelText(const char *data, size_t size, LevelData &level, LevelError &error) {
+  level.Width = level.Height = 0;
+  level.Tiles.clear();
+  // every code takes at least one digit and one separator, so this is the only allocation
+  level.Tiles.reserve(size / 2 + 1);
+
+  const char *p = data, *end = data + size;
+  unsigned int line = 1;
+  while (p < end) {
+    const char *lineStart = p;
+    unsigned int rowWidth = 0;
+
+    while (p < end && *p != '\n') {
+      if (*p == ' ' || *p == '\t' || *p == '\r') {
+        p++;
+        continue;
+      }
+
+      unsigned int code;
+      auto [next, ec] = std::from_chars(p, end, code);
+      unsigned int column = p - lineStart + 1;
+      if (ec == std::errc::result_out_of_range || (ec == std::errc() && code > 255))
+        return fail(error, line, column, "tile code out of range");
+      if (ec != std::errc() || (next < end && *next != ' ' && *next != '\t' && *next != '\r' && *next != '\n'))
+        return fail(error, line, column, "expected a tile code");
+
+      level.Tiles.push_back(static_cast<uint8_t>(code));
+      rowWidth++;
+      p = next;
+    }
+
+    if (rowWidth > 0) {
+      if (level.Height == 0)
+        level.Width = rowWidth;
+      else if (rowWidth != level.Width)
+        return fail(error, line, p - lineStart + 1, "row width differs from the first row");
+      level.Height++;
+    }
+
+    if (p < end)
+      p++;
+    line++;
+  }
+
+  if (level.Height == 0)
+    return fail(error, line, 1, "level has no tiles");
+  return true;
+}
+
+bool ReadLevelBinary(const uint8_t *data, size_t size, LevelData &level, LevelError &error) {
+  LevelFileHeader header;
+  if (size < sizeof(header))
+    return fail(error, 0, 0, "truncated header");
+  std::memcpy(&header, data, sizeof(header));
+
+  if (std::memcmp(header.Magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC)) != 0)
+    return fail(error, 0, 0, "not a binary level");
+  if (header.Version != LEVEL_VERSION)
+    return fail(error, 0, 0, "unsupported version");
+  if (header.PaletteSize == 0 || header.PaletteSize > 256)
+    return fail(error, 0, 0, "bad palette size");
+  if (header.Width == 0 || header.Height == 0)
+    return fail(error, 0, 0, "level has no tiles");
+  if (size - sizeof(header) < (size_t)header.PaletteSize + header.PayloadSize)
+    return fail(error, 0, 0, "truncated payload");
+
+  const uint8_t *palette = data + sizeof(header);
+  const uint8_t *payload = palette + header.PaletteSize;
+  size_t count = (size_t)header.Width * header.Height;
+
+  // the header alone must not be able to ask for more tiles than the payload can describe
+  if (header.Flags & LEVEL_FLAG_RLE) {
+    if (count > (size_t)(header.PayloadSize / 2) * 255)
+      return fail(error, 0, 0, "runs do not cover the level");
+  }
+  else if (header.PayloadSize != count)
+    return fail(error, 0, 0, "payload size does not match the level");
+
+  level.Width = header.Width;
+  level.Height = header.Height;
+  level.Tiles.resize(count);
+
+  if (header.Flags & LEVEL_FLAG_RLE) {
+    size_t tile = 0;
+    for (uint32_t i = 0; i + 1 < header.PayloadSize; i += 2) {
+      uint8_t run = payload[i], index = payload[i + 1];
+      if (run == 0 || index >= header.PaletteSize || tile + run > count)
+        return fail(error, 0, 0, "corrupt run");
+      std::memset(&level.Tiles[tile], palette[index], run);
+      tile += run;
+    }
+    if (tile != count)
+      return fail(error, 0, 0, "runs do not cover the level");
+  }
+  else {
+    for (size_t i = 0; i < count; i++) {
+      if (payload[i] >= header.PaletteSize)
+        return fail(error, 0, 0, "palette index out of range");
+      level.Tiles[i] = palette[payload[i]];
+    }
+  }
+  return true;
+}
+
+bool WriteLevelBinary(const char *file, const LevelData &level, bool rle) {
+  // palette in ascending code order, so the output only depends on the tiles
+  uint8_t indexOf[256];
+  bool used[256] = { };
+  for (uint8_t code : level.Tiles)
+    used[code] = true;
+
+  std::vector<uint8_t> palette;
+  for (unsigned int code = 0; code < 256; code++) {
+    if (used[code]) {
+      indexOf[code] = palette.size();
+      palette.push_back(code);
+    }
+  }
+
+  std::vector<uint8_t> payload;
+  if (rle) {
+    for (size_t i = 0; i < level.Tiles.size(); ) {
+      uint8_t code = level.Tiles[i];
+      size_t run = 1;
+      while (i + run < level.Tiles.size() && level.Tiles[i + run] == code && run < 255)
+        run++;
+      payload.push_back(run);
+      payload.push_back(indexOf[code]);
+      i += run;
+    }
+  }
+  else {
+    payload.reserve(level.Tiles.size());
+    for (uint8_t code : level.Tiles)
+      payload.push_back(indexOf[code]);
+  }
+
+  LevelFileHeader header;
+  std::memcpy(header.Magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC));
+  header.Version = LEVEL_VERSION;
+  header.Flags = rle ? LEVEL_FLAG_RLE : 0;
+  header.Width = level.Width;
+  header.Height = level.Height;
+  header.PaletteSize = palette.size();
+  header.PayloadSize = payload.size();
+
+  std::ofstream out(file, std::ios::binary);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(palette.data()), palette.size());
+  out.write(reinterpret_cast<const char *>(payload.data()), payload.size());
+  return static_cast<bool>(out);
+}
+
+bool LoadLevelFile(const char *file, LevelData &level) {
+  int fd = open(file, O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "Error: Failed to open level " << file << "\n";
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    std::cerr << "Error: Level " << file << " is empty\n";
+    close(fd);
+    return false;
+  }
+
+  void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    std::cerr << "Error: Failed to map level " << file << "\n";
+    return false;
+  }
+
+  LevelError error;
+  bool ok;
+  bool binary = (size_t)info.st_size >= sizeof(LEVEL_MAGIC) && std::memcmp(mapped, LEVEL_MAGIC, sizeof(LEVEL_MAGIC)) == 0;
+  if (binary)
+    ok = ReadLevelBinary(static_cast<const uint8_t *>(mapped), info.st_size, level, error);
+  else
+    ok = ParseLevelText(static_cast<const char *>(mapped), info.st_size, level, error);
+  munmap(mapped, info.st_size);
+
+  if (!ok && binary)
+    std::cerr << "Error: " << file << ": " << error.Message << "\n";
+  else if (!ok)
+    std::cerr << "Error: " << file << ":" << error.Line << ":" << error.Column << ": " << error.Message << "\n";
+  return ok;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// tile codes of a level, row-major
+struct LevelData {
+  unsigned int Width = 0, Height = 0;
+  std::vector<uint8_t> Tiles;
+
+  uint8_t At(unsigned int x, unsigned int y) const { return Tiles[y * Width + x]; }
+};
+
+// Binary level format, host byte order:
+//   LevelFileHeader, uint8_t palette[PaletteSize], payload[PayloadSize]
+// The payload holds one palette index per tile, row-major, either raw or as (run length, index) byte pairs.
+const char LEVEL_MAGIC[4] = { 'B', 'L', 'V', 'L' };
+const uint16_t LEVEL_VERSION = 1;
+const uint16_t LEVEL_FLAG_RLE = 1 << 0;
+
+struct LevelFileHeader {
+  char Magic[4];
+  uint16_t Version;
+  uint16_t Flags;
+  uint32_t Width, Height;
+  uint32_t PaletteSize;
+  uint32_t PayloadSize;
+};
+
+struct LevelError {
+  unsigned int Line = 0, Column = 0;
+  std::string Message;
+};
+
+// Parses the text format: one row per line, whitespace separated tile codes (0-255).
+// Blank lines are skipped and every row must be as wide as the first. Reuses level's buffers.
+bool ParseLevelText(const char *data, size_t size, LevelData &level, LevelError &error);
+
+bool ReadLevelBinary(const uint8_t *data, size_t size, LevelData &level, LevelError &error);
+bool WriteLevelBinary(const char *file, const LevelData &level, bool rle);
+
+// maps the file and loads it as binary or text depending on its magic number; errors go to std::cerr
+bool LoadLevelFile(const char *file, LevelData &level);
@@ -0,0 +1,115 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Each ring has one writer, its thread; Dump() may read it at any time. The slots are atomics and
+// Recorded is published after the slot is written, so a reader can tell which copied events may
+// have been overwritten meanwhile and drop them instead of reporting torn ones.
+struct ProfileSlot {
+  std::atomic<const char *> Name;
+  std::atomic<uint64_t> Begin, End;
+};
+
+struct ProfileRing {
+  std::unique_ptr<ProfileSlot[]> Slots;
+  std::atomic<uint64_t> Recorded{0};
+  unsigned int Thread = 0;
+};
+
+// rings outlive their threads so zones from finished workers still make it into the dump
+static std::mutex registryMutex;
+static std::vector<std::shared_ptr<ProfileRing>> registry;
+
+static ProfileRing &threadRing() {
+  thread_local std::shared_ptr<ProfileRing> ring;
+  if (!ring) {
+    ring = std::make_shared<ProfileRing>();
+    ring->Slots.reset(new ProfileSlot[Profiler::RING_SIZE]());
+    std::lock_guard<std::mutex> lock(registryMutex);
+    ring->Thread = registry.size() + 1;
+    registry.push_back(ring);
+  }
+  return *ring;
+}
+
+std::atomic<bool> Profiler::Enabled(false);
+
+uint64_t Profiler::Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::Record(const char *name, uint64_t begin, uint64_t end) {
+  ProfileRing &ring = threadRing();
+  uint64_t index = ring.Recorded.load(std::memory_order_relaxed);
+  ProfileSlot &slot = ring.Slots[index % RING_SIZE];
+  // a reader that sees any of the stores below also sees the count they came after
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.Name.store(name, std::memory_order_relaxed);
+  slot.Begin.store(begin, std::memory_order_relaxed);
+  slot.End.store(end, std::memory_order_relaxed);
+  ring.Recorded.store(index + 1, std::memory_order_release);
+}
+
+// the ring's events that were complete and not overwritten while they were copied
+static std::vector<ProfileEvent> copyRing(const ProfileRing &ring) {
+  uint64_t recorded = ring.Recorded.load(std::memory_order_acquire);
+  uint64_t first = recorded - std::min<uint64_t>(recorded, Profiler::RING_SIZE);
+
+  std::vector<ProfileEvent> events;
+  events.reserve(recorded - first);
+  for (uint64_t i = first; i < recorded; i++) {
+    const ProfileSlot &slot = ring.Slots[i % Profiler::RING_SIZE];
+    events.push_back({ slot.Name.load(std::memory_order_relaxed), slot.Begin.load(std::memory_order_relaxed), slot.End.load(std::memory_order_relaxed) });
+  }
+
+  // event i shares its slot with i + RING_SIZE, which may have been written, or be mid-write,
+  // once the count reaches i + RING_SIZE
+  std::atomic_thread_fence(std::memory_order_acquire);
+  uint64_t now = ring.Recorded.load(std::memory_order_relaxed);
+  uint64_t torn = now >= Profiler::RING_SIZE ? now - Profiler::RING_SIZE + 1 : 0;
+  if (torn > first)
+    events.erase(events.begin(), events.begin() + std::min<uint64_t>(torn - first, events.size()));
+  return events;
+}
+
+bool Profiler::Dump(const char *file) {
+  std::vector<std::pair<unsigned int, std::vector<ProfileEvent>>> rings;
+  {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const auto &ring : registry)
+      rings.emplace_back(ring->Thread, copyRing(*ring));
+  }
+
+  uint64_t origin = UINT64_MAX;
+  for (const auto &ring : rings) {
+    for (const ProfileEvent &event : ring.second)
+      origin = std::min(origin, event.Begin);
+  }
+
+  // complete ("X") events with microsecond timestamps relative to the oldest zone kept
+  std::ofstream out(file);
+  out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+  bool first = true;
+  for (const auto &ring : rings) {
+    for (const ProfileEvent &event : ring.second) {
+      out << (first ? "" : ",\n") << "{\"name\":\"" << event.Name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring.first
+        << ",\"ts\":" << (event.Begin - origin) / 1000.0 << ",\"dur\":" << (event.End - event.Begin) / 1000.0 << "}";
+      first = false;
+    }
+  }
+  out << "\n]}\n";
+
+  if (!out) {
+    std::cerr << "Error: Failed to write trace " << file << "\n";
+    return false;
+  }
+  std::cout << "Wrote trace " << file << "\n";
+  return true;
+}
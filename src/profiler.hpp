@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Scoped CPU zones: PROFILE_ZONE("Update") times the rest of the enclosing scope. Each thread
+// records into its own ring of the latest RING_SIZE zones; Dump() writes them all as a Chrome
+// trace (chrome://tracing, ui.perfetto.dev). While disabled a zone costs one relaxed load.
+struct ProfileEvent {
+  const char *Name;
+  uint64_t Begin, End; // steady_clock nanoseconds
+};
+
+class Profiler {
+public:
+  static const unsigned int RING_SIZE = 1 << 16;
+  static std::atomic<bool> Enabled;
+
+  static uint64_t Now();
+  static void Record(const char *name, uint64_t begin, uint64_t end);
+  // safe while other threads record; zones overwritten during the copy are left out
+  static bool Dump(const char *file);
+
+private:
+  Profiler() {}
+};
+
+class ProfileZone {
+public:
+  explicit ProfileZone(const char *name) : name(Profiler::Enabled.load(std::memory_order_relaxed) ? name : nullptr), begin(this->name ? Profiler::Now() : 0) { }
+  ~ProfileZone() {
+    if (name)
+      Profiler::Record(name, begin, Profiler::Now());
+  }
+
+  ProfileZone(const ProfileZone &) = delete;
+  ProfileZone &operator=(const ProfileZone &) = delete;
+
+private:
+  const char *name;
+  uint64_t begin;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
@@ -2,20 +2,92 @@
 #include <GLFW/glfw3.h>
 
 #include "game.hpp"
+#include "input_replay.hpp"
+#include "profiler.hpp"
 #include "resource_manager.hpp"
+#include "render_state.hpp"
+#include "spsc_queue.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <thread>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
 void APIENTRY glDebugOutput(GLenum source, GLenum type, unsigned int id, GLenum severity, GLsizei length, const char *message, const void *userParam);
+int runHeadless(unsigned long frames, double simHz);
+int runReplay(const char *file);
+void simulate(double simHz);
+void render(GLFWwindow *window);
+void reportStartup();
 
 const unsigned int SCREEN_WIDTH = 800;
 const unsigned int SCREEN_HEIGHT = 600;
 
+const double DEFAULT_SIM_HZ = 240.0;
+// after a long hitch, drop the backlog instead of spiralling into ever longer catch-up bursts
+const unsigned int MAX_SUBSTEPS = 8;
+
 Game Breakout(SCREEN_WIDTH, SCREEN_HEIGHT);
 
+// key changes from the window thread to the simulation thread, applied before the next tick
+struct KeyEvent {
+  int Key;
+  bool Pressed;
+};
+SpscQueue<KeyEvent, 256> KeyEvents;
+std::atomic<bool> Simulating(false);
+std::atomic<bool> Rendering(false);
+
+// the window thread has no GL context, so resizes are applied by the render thread
+std::atomic<int> FramebufferWidth(SCREEN_WIDTH);
+std::atomic<int> FramebufferHeight(SCREEN_HEIGHT);
+
+// --record: every tick's input goes here and is saved on exit
+const char *RecordFile = nullptr;
+InputRecorder Recorder;
+
+// --profile FILE captures from launch; F12 starts a capture or writes the current one
+const char *ProfileFile = "trace.json";
+
+// cold start is measured from static initialisation, before main runs
+const std::chrono::steady_clock::time_point LaunchTime = std::chrono::steady_clock::now();
+
 int main(int argc, char *argv[]) {
+  bool headless = false;
+  unsigned long frames = 1000000;
+  double simHz = DEFAULT_SIM_HZ;
+  const char *replayFile = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--headless") == 0)
+      headless = true;
+    else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+      frames = std::strtoul(argv[++i], nullptr, 10);
+    else if (std::strcmp(argv[i], "--hz") == 0 && i + 1 < argc)
+      simHz = std::strtod(argv[++i], nullptr);
+    else if (std::strcmp(argv[i], "--ccd") == 0)
+      Breakout.ContinuousCollision = true;
+    else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+      RecordFile = argv[++i];
+    else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+      replayFile = argv[++i];
+    else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+      ProfileFile = argv[++i];
+      Profiler::Enabled = true;
+    }
+  }
+  if (simHz <= 0.0)
+    simHz = DEFAULT_SIM_HZ;
+  Recorder.Begin(1.0 / simHz, Breakout.ContinuousCollision ? REPLAY_FLAG_CCD : 0);
+
+  if (replayFile)
+    return runReplay(replayFile);
+  if (headless)
+    return runHeadless(frames, simHz);
+
   glfwInit();
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
@@ -51,46 +123,187 @@ int main(int argc, char *argv[]) {
 
   Breakout.Init();
 
-  float deltaTime = 0.0f;
-  float lastFrame = 0.0f;
+  // the simulation ticks on its own thread and drawing happens on another, so a stall in the
+  // driver or in vsync holds back neither physics nor input; this thread only waits for events
+  // and hands key changes to the simulation as soon as they arrive
+  Simulating = true;
+  std::thread simulation(simulate, simHz);
+  glfwMakeContextCurrent(nullptr);
+  Rendering = true;
+  std::thread renderer(render, window);
+
+  while (!glfwWindowShouldClose(window))
+    glfwWaitEvents();
+
+  Rendering = false;
+  renderer.join();
+  Simulating = false;
+  simulation.join();
+  glfwMakeContextCurrent(window);
+
+  if (RecordFile)
+    Recorder.Save(RecordFile, Breakout.StateHash());
+  if (Profiler::Enabled)
+    Profiler::Dump(ProfileFile);
+  Breakout.Clear();
+  ResourceManager::Clear();
 
-  while (!glfwWindowShouldClose(window)) {
-    float currentFrame = glfwGetTime();
-    deltaTime = currentFrame - lastFrame;
-    lastFrame = currentFrame;
-    glfwPollEvents();
+  glfwTerminate();
+  return 0;
+}
 
-    Breakout.ProcessInput(deltaTime);
+int runHeadless(unsigned long frames, double simHz) {
+  const float dt = 1.0 / simHz;
 
-    Breakout.Update(deltaTime);
+  ResourceManager::Headless = true;
+  Breakout.Init();
+  // no frame is presented headless, report once everything is loaded
+  reportStartup();
+
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned long frame = 0; frame < frames; frame++) {
+    // nobody is at the keyboard, keep launching the ball so every frame does real work
+    Breakout.Keys[GLFW_KEY_SPACE] = true;
+    if (RecordFile)
+      Recorder.Record(Breakout.Keys);
+    Breakout.Tick(dt);
+    Breakout.Render();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  std::cout << "Simulated " << frames << " frames in " << elapsed.count() << "s ("
+    << frames / elapsed.count() << " frames/s)\n";
+
+  LevelStats stats = Breakout.Levels[Breakout.Level].Stats();
+  std::cout << "Level " << Breakout.Level << ": " << stats.BricksRemaining << " bricks remaining, "
+    << stats.BricksDestroyed << " destroyed (" << stats.DestroyedPerSecond << "/s sim time)\n";
+
+  if (RecordFile)
+    Recorder.Save(RecordFile, Breakout.StateHash());
+  if (Profiler::Enabled)
+    Profiler::Dump(ProfileFile);
+  ResourceManager::Clear();
+  return 0;
+}
+
+// runs fixed ticks against its own clock until Simulating is cleared
+void simulate(double simHz) {
+  typedef std::chrono::steady_clock Clock;
+  const float dt = 1.0 / simHz;
+  const Clock::duration step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / simHz));
+
+  Clock::time_point next = Clock::now();
+  while (Simulating.load(std::memory_order_acquire)) {
+    KeyEvent event;
+    while (KeyEvents.Pop(event))
+      Breakout.Keys[event.Key] = event.Pressed;
+
+    if (RecordFile)
+      Recorder.Record(Breakout.Keys);
+    Breakout.Tick(dt);
+
+    next += step;
+    Clock::time_point now = Clock::now();
+    if (now - next > MAX_SUBSTEPS * step)
+      next = now;
+    std::this_thread::sleep_until(next);
+  }
+}
+
+// draws the latest snapshot until Rendering is cleared; owns the GL context meanwhile
+void render(GLFWwindow *window) {
+  glfwMakeContextCurrent(window);
+  int width = SCREEN_WIDTH, height = SCREEN_HEIGHT;
+  bool firstFrame = true;
+
+  while (Rendering.load(std::memory_order_acquire)) {
+    PROFILE_ZONE("Frame");
+    int newWidth = FramebufferWidth.load(std::memory_order_relaxed);
+    int newHeight = FramebufferHeight.load(std::memory_order_relaxed);
+    if (newWidth != width || newHeight != height) {
+      width = newWidth;
+      height = newHeight;
+      glViewport(0, 0, width, height);
+    }
 
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
     Breakout.Render();
 
-    glfwSwapBuffers(window);
+    {
+      PROFILE_ZONE("SwapBuffers");
+      glfwSwapBuffers(window);
+    }
+    RenderState::NewFrame();
+
+    if (firstFrame) {
+      reportStartup();
+      firstFrame = false;
+    }
   }
 
+  glfwMakeContextCurrent(nullptr);
+}
+
+// replays a recording headlessly; exits non-zero when the final state differs from the recording's
+int runReplay(const char *file) {
+  InputPlayer player;
+  if (!player.Load(file))
+    return 1;
+
+  ResourceManager::Headless = true;
+  Breakout.ContinuousCollision = player.Header.Flags & REPLAY_FLAG_CCD;
+  Breakout.Init();
+
+  auto start = std::chrono::steady_clock::now();
+  while (!player.Done()) {
+    player.Apply(Breakout.Keys);
+    Breakout.Tick(player.Header.Step);
+    Breakout.Render();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  uint64_t hash = Breakout.StateHash();
+  bool match = hash == player.Header.FinalHash;
+  std::cout << "Replayed " << player.Header.Ticks << " ticks in " << elapsed.count() << "s ("
+    << player.Header.Ticks / elapsed.count() << " ticks/s)\n"
+    << "State hash " << std::hex << hash << (match ? " matches" : " differs from") << " the recording ("
+    << player.Header.FinalHash << ")" << std::dec << "\n";
+
+  if (Profiler::Enabled)
+    Profiler::Dump(ProfileFile);
   ResourceManager::Clear();
+  return match ? 0 : 1;
+}
 
-  glfwTerminate();
-  return 0;
+void reportStartup() {
+  std::chrono::duration<double, std::milli> startup = std::chrono::steady_clock::now() - LaunchTime;
+  std::cout << "Startup: first frame after " << startup.count() << "ms (shaders " << Shader::Stats.CompileMilliseconds << "ms, "
+    << Shader::Stats.ProgramsRestored << " restored, " << Shader::Stats.ProgramsCompiled << " compiled)\n";
 }
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode) {
   if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
     glfwSetWindowShouldClose(window, true);
 
-  if (key >= 0 && key < 1024) {
-    if (action == GLFW_PRESS)
-      Breakout.Keys[key] = true;
-    else if (action == GLFW_RELEASE)
-      Breakout.Keys[key] = false;
+  if (key == GLFW_KEY_F3 && action == GLFW_PRESS)
+    Breakout.ShowOverlay = !Breakout.ShowOverlay;
+
+  if (key == GLFW_KEY_F12 && action == GLFW_PRESS) {
+    if (Profiler::Enabled)
+      Profiler::Dump(ProfileFile);
+    else
+      Profiler::Enabled = true;
   }
+
+  // Keys belongs to the simulation thread; a full queue drops the change rather than block
+  if (key >= 0 && key < 1024 && action != GLFW_REPEAT)
+    KeyEvents.Push({ key, action == GLFW_PRESS });
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-  glViewport(0, 0, width, height);
+  FramebufferWidth = width;
+  FramebufferHeight = height;
 }
 
 void APIENTRY glDebugOutput(GLenum source, GLenum type, unsigned int id, GLenum severity, GLsizei length, const char *message, const void *userParam) {
@@ -0,0 +1,73 @@
+#include "render_state.hpp"
+
+RenderStats RenderState::Stats = { 0, 0 };
+RenderStats RenderState::LastFrame = { 0, 0 };
+
+unsigned int RenderState::program = 0;
+unsigned int RenderState::activeUnit = 0;
+unsigned int RenderState::textures[RenderState::MAX_TEXTURE_UNITS] = { };
+unsigned int RenderState::vertexArray = 0;
+
+void RenderState::UseProgram(unsigned int program) {
+  if (changed(RenderState::program, program))
+    glUseProgram(program);
+}
+
+void RenderState::ActiveTexture(unsigned int unit) {
+  if (changed(activeUnit, unit - GL_TEXTURE0))
+    glActiveTexture(unit);
+}
+
+void RenderState::BindTexture(unsigned int texture) {
+  if (changed(textures[activeUnit], texture))
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void RenderState::BindVertexArray(unsigned int vertexArray) {
+  if (changed(RenderState::vertexArray, vertexArray))
+    glBindVertexArray(vertexArray);
+}
+
+void RenderState::ForgetProgram(unsigned int program) {
+  // a deleted program stays in use until another is bound, so force the next bind
+  if (RenderState::program == program)
+    RenderState::program = ~0u;
+}
+
+void RenderState::ForgetTexture(unsigned int texture) {
+  // deleting a texture unbinds it from every unit
+  for (unsigned int &bound : textures) {
+    if (bound == texture)
+      bound = 0;
+  }
+}
+
+void RenderState::ForgetVertexArray(unsigned int vertexArray) {
+  if (RenderState::vertexArray == vertexArray)
+    RenderState::vertexArray = 0;
+}
+
+void RenderState::NewFrame() {
+  LastFrame = Stats;
+  Stats = { 0, 0 };
+}
+
+void RenderState::Invalidate() {
+  // ~0u never matches a real GL name, so every next bind goes through
+  program = ~0u;
+  vertexArray = ~0u;
+  activeUnit = 0;
+  glActiveTexture(GL_TEXTURE0);
+  for (unsigned int &texture : textures)
+    texture = ~0u;
+}
+
+bool RenderState::changed(unsigned int &current, unsigned int value) {
+  if (current == value) {
+    Stats.BindsSkipped++;
+    return false;
+  }
+  current = value;
+  Stats.BindsIssued++;
+  return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <glad/glad.h>
+
+struct RenderStats {
+  unsigned int BindsIssued;
+  unsigned int BindsSkipped;
+};
+
+// shadows the bits of GL state the renderer touches so redundant binds never reach the driver
+class RenderState {
+public:
+  static RenderStats Stats;
+  static RenderStats LastFrame;
+
+  static void UseProgram(unsigned int program);
+  static void ActiveTexture(unsigned int unit);
+  static void BindTexture(unsigned int texture);
+  static void BindVertexArray(unsigned int vertexArray);
+
+  // call before deleting a GL name, which the driver may hand out again for a new object
+  static void ForgetProgram(unsigned int program);
+  static void ForgetTexture(unsigned int texture);
+  static void ForgetVertexArray(unsigned int vertexArray);
+
+  static void NewFrame();
+  static void Invalidate();
+
+private:
+  static const unsigned int MAX_TEXTURE_UNITS = 16;
+
+  static unsigned int program;
+  static unsigned int activeUnit;
+  static unsigned int textures[MAX_TEXTURE_UNITS];
+  static unsigned int vertexArray;
+
+  RenderState() {}
+
+  static bool changed(unsigned int &current, unsigned int value);
+};
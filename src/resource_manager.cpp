@@ -1,46 +1,195 @@
 #include "resource_manager.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <fstream>
 
 #include <stb_image.h>
 
-std::map<std::string, Texture2D> ResourceManager::Textures;
-std::map<std::string, Shader> ResourceManager::Shaders;
+#include "texture_atlas.hpp"
+#include "profiler.hpp"
+#include "render_state.hpp"
 
-Shader ResourceManager::LoadShader(const char *vShaderFile, const char *fShaderFile, std::string name) {
-  Shaders[name] = loadShaderFromFile(vShaderFile, fShaderFile);
-  return Shaders[name];
+bool ResourceManager::Headless = false;
+std::vector<Shader> ResourceManager::shaders(1);
+std::vector<Texture2D> ResourceManager::textures(1);
+std::unordered_map<std::string, unsigned int> ResourceManager::shaderNames;
+std::unordered_map<std::string, unsigned int> ResourceManager::textureNames;
+std::deque<ResourceManager::PendingTexture> ResourceManager::pending;
+
+ShaderHandle ResourceManager::LoadShader(const char *vShaderFile, const char *fShaderFile, std::string name) {
+  PROFILE_ZONE("ResourceManager::LoadShader");
+  ShaderHandle handle = internShader(name);
+  shaders[handle.Index] = loadShaderFromFile(vShaderFile, fShaderFile);
+  return handle;
+}
+
+ShaderHandle ResourceManager::LoadShader(const char *vShaderFile, const char *gShaderFile ,const char *fShaderFile, std::string name) {
+  PROFILE_ZONE("ResourceManager::LoadShader");
+  ShaderHandle handle = internShader(name);
+  shaders[handle.Index] = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile);
+  return handle;
 }
 
-Shader ResourceManager::LoadShader(const char *vShaderFile, const char *gShaderFile ,const char *fShaderFile, std::string name) {
-  Shaders[name] = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile);
-  return Shaders[name];
+TextureHandle ResourceManager::LoadTexture(const char *file, bool alpha, std::string name) {
+  PROFILE_ZONE("ResourceManager::LoadTexture");
+  TextureHandle handle = internTexture(name);
+  textures[handle.Index] = loadTextureFromFile(file, alpha);
+  return handle;
 }
 
-Shader ResourceManager::GetShader(std::string name) {
-  return Shaders[name];
+ShaderHandle ResourceManager::FindShader(const std::string &name) {
+  auto found = shaderNames.find(name);
+  return ShaderHandle{ found != shaderNames.end() ? found->second : 0 };
 }
 
-Texture2D ResourceManager::LoadTexture(const char *file, bool alpha, std::string name) {
-  Textures[name] = loadTextureFromFile(file, alpha);
-  return Textures[name];
+TextureHandle ResourceManager::FindTexture(const std::string &name) {
+  auto found = textureNames.find(name);
+  return TextureHandle{ found != textureNames.end() ? found->second : 0 };
+}
+
+std::vector<TextureHandle> ResourceManager::LoadTexturesAsync(const std::vector<TextureSource> &sources) {
+  std::vector<TextureHandle> handles;
+  for (const TextureSource &source : sources) {
+    handles.push_back(internTexture(source.Name));
+    pending.push_back({ source, handles.back(), TexturePixels(), std::future<void>() });
+    // deque elements never move on push_back, the worker can keep a pointer
+    PendingTexture *texture = &pending.back();
+    texture->Decoded = workers().Submit([texture] {
+      texture->Image = decodeImage(texture->Source.File, 0);
+    });
+  }
+  return handles;
 }
 
-Texture2D ResourceManager::GetTexture(std::string name) {
-  return Textures[name];
+void ResourceManager::WaitTextures() {
+  PROFILE_ZONE("ResourceManager::WaitTextures");
+  // upload each texture as soon as it is ready while the later ones are still decoding
+  for (PendingTexture &texture : pending) {
+    texture.Decoded.wait();
+    textures[texture.Handle.Index] = uploadTexture(texture.Image, texture.Source.Alpha);
+  }
+  pending.clear();
+}
+
+TextureHandle ResourceManager::LoadAtlas(const std::vector<AtlasSource> &sources, std::string name) {
+  PROFILE_ZONE("ResourceManager::LoadAtlas");
+  const unsigned int ATLAS_MAX_WIDTH = 2048;
+  const unsigned int ATLAS_PADDING = 2;
+
+  std::vector<TexturePixels> decoded(sources.size());
+  std::vector<std::future<void>> done;
+  for (unsigned int i = 0; i < sources.size(); i++) {
+    const char *file = sources[i].File;
+    TexturePixels *image = &decoded[i];
+    done.push_back(workers().Submit([file, image] { *image = decodeImage(file, 4); }));
+  }
+
+  std::vector<const unsigned char *> images(sources.size());
+  std::vector<glm::uvec2> sizes(sources.size());
+  for (unsigned int i = 0; i < sources.size(); i++) {
+    done[i].wait();
+    images[i] = decoded[i].Data;
+    sizes[i] = glm::uvec2(decoded[i].Width, decoded[i].Height);
+  }
+
+  AtlasPacker packer(ATLAS_MAX_WIDTH, ATLAS_PADDING);
+  std::vector<AtlasRect> rects;
+  if (!packer.Pack(sizes, rects)) {
+    // still usable, just one bind per sprite instead of one for all of them
+    std::cerr << "Error: Atlas " << name << " does not fit in " << ATLAS_MAX_WIDTH << " pixels, loading its images separately\n";
+    for (unsigned int i = 0; i < sources.size(); i++)
+      textures[internTexture(sources[i].Name).Index] = uploadTexture(decoded[i], true);
+    return TextureHandle();
+  }
+
+  std::vector<unsigned char> pixels(Headless ? 0 : packer.Width * packer.Height * 4, 0);
+  for (unsigned int i = 0; i < sources.size(); i++) {
+    if (!images[i] || rects[i].Width == 0)
+      continue;
+
+    // copy the image and extrude its border into the padding so linear filtering never picks up a neighbour
+    const AtlasRect &rect = rects[i];
+    int pad = ATLAS_PADDING;
+    for (int y = -pad; y < (int)rect.Height + pad; y++) {
+      int srcY = glm::clamp(y, 0, (int)rect.Height - 1);
+      for (int x = -pad; x < (int)rect.Width + pad; x++) {
+        int srcX = glm::clamp(x, 0, (int)rect.Width - 1);
+        const unsigned char *src = images[i] + (srcY * rect.Width + srcX) * 4;
+        unsigned char *dst = &pixels[((rect.Y + y) * packer.Width + rect.X + x) * 4];
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+        dst[3] = src[3];
+      }
+    }
+  }
+
+  Texture2D atlas;
+  atlas.Internal_Format = GL_RGBA;
+  atlas.Image_Format = GL_RGBA;
+  atlas.Wrap_S = GL_CLAMP_TO_EDGE;
+  atlas.Wrap_T = GL_CLAMP_TO_EDGE;
+  if (Headless) {
+    atlas.Width = packer.Width;
+    atlas.Height = packer.Height;
+  }
+  else {
+    atlas.Generate(packer.Width, packer.Height, pixels.data());
+  }
+  TextureHandle handle = internTexture(name);
+  textures[handle.Index] = atlas;
+
+  for (unsigned int i = 0; i < sources.size(); i++) {
+    Texture2D sprite = atlas;
+    sprite.Width = rects[i].Width;
+    sprite.Height = rects[i].Height;
+    sprite.UV = glm::vec4(rects[i].X / (float)packer.Width, rects[i].Y / (float)packer.Height,
+                          (rects[i].X + rects[i].Width) / (float)packer.Width, (rects[i].Y + rects[i].Height) / (float)packer.Height);
+    textures[internTexture(sources[i].Name).Index] = sprite;
+  }
+  return handle;
 }
 
 void ResourceManager::Clear() {
-  for (auto iter : Shaders)
-    glDeleteProgram(iter.second.ID);
+  if (!Headless) {
+    for (const Shader &shader : shaders) {
+      RenderState::ForgetProgram(shader.ID);
+      glDeleteProgram(shader.ID);
+    }
+
+    // atlas sprites share their atlas' ID, deleting a name twice is a no-op
+    for (const Texture2D &texture : textures) {
+      RenderState::ForgetTexture(texture.ID);
+      glDeleteTextures(1, &texture.ID);
+    }
+  }
 
-  for (auto iter : Textures)
-    glDeleteTextures(1, &iter.second.ID);
+  shaders.assign(1, Shader());
+  textures.assign(1, Texture2D());
+  shaderNames.clear();
+  textureNames.clear();
+}
+
+ShaderHandle ResourceManager::internShader(const std::string &name) {
+  auto inserted = shaderNames.emplace(name, shaders.size());
+  if (inserted.second)
+    shaders.emplace_back();
+  return ShaderHandle{ inserted.first->second };
+}
+
+TextureHandle ResourceManager::internTexture(const std::string &name) {
+  auto inserted = textureNames.emplace(name, textures.size());
+  if (inserted.second)
+    textures.emplace_back();
+  return TextureHandle{ inserted.first->second };
 }
 
 Shader ResourceManager::loadShaderFromFile(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile) {
+  if (Headless)
+    return Shader();
+
   std::string vertexCode;
   std::string fragmentCode;
   std::string geometryCode;
@@ -86,14 +235,46 @@ Shader ResourceManager::loadShaderFromFile(const char *vShaderFile, const char *
 }
 
 Texture2D ResourceManager::loadTextureFromFile(const char *file, bool alpha) {
+  TexturePixels image = decodeImage(file, 0);
+  return uploadTexture(image, alpha);
+}
+
+ThreadPool &ResourceManager::workers() {
+  static ThreadPool pool;
+  return pool;
+}
+
+TexturePixels ResourceManager::decodeImage(const char *file, int channels) {
+  PROFILE_ZONE("ResourceManager::decodeImage");
+  TexturePixels image;
+  if (Headless) {
+    if (!stbi_info(file, &image.Width, &image.Height, &image.Channels)) {
+      std::cerr << "Error: Failed to load texture " << file << "\n";
+      image.Width = image.Height = 0;
+    }
+    return image;
+  }
+
+  if (!LoadTexturePixels(file, channels, image))
+    image = TexturePixels();
+  return image;
+}
+
+Texture2D ResourceManager::uploadTexture(TexturePixels &image, bool alpha) {
   Texture2D texture;
   if (alpha) {
     texture.Internal_Format = GL_RGBA;
     texture.Image_Format = GL_RGBA;
   }
-  int width, height, nrChannels;
-  unsigned char *data = stbi_load(file, &width, &height, &nrChannels, 0);
-  texture.Generate(width, height, data);
-  stbi_image_free(data);
+  if (Headless) {
+    texture.Width = image.Width;
+    texture.Height = image.Height;
+    return texture;
+  }
+
+  // the baked mips only reach the GPU when the texture actually samples them
+  bool mipmapped = texture.Filter_Min != GL_LINEAR && texture.Filter_Min != GL_NEAREST;
+  texture.Generate(image.Width, image.Height, image.Data, mipmapped ? std::max(1u, image.Levels) : 1);
+  image = TexturePixels();
   return texture;
 }
@@ -1,32 +1,99 @@
 #pragma once
 
 
-#include <map>
+#include <deque>
+#include <future>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <glad/glad.h>
 
 #include "texture.hpp"
+#include "texture_cache.hpp"
 #include "shader.hpp"
+#include "thread_pool.hpp"
+
+// Interned resource IDs, indices into ResourceManager's slot arrays. Index 0 is the empty
+// resource a failed lookup resolves to; a name keeps its handle when it is loaded again.
+struct TextureHandle {
+  unsigned int Index = 0;
+};
+
+struct ShaderHandle {
+  unsigned int Index = 0;
+};
+
+struct AtlasSource {
+  const char *File;
+  std::string Name;
+};
+
+struct TextureSource {
+  const char *File;
+  bool Alpha;
+  std::string Name;
+};
 
 class ResourceManager {
 public:
-  static std::map<std::string, Shader> Shaders;
-  static std::map<std::string, Texture2D> Textures;
+  // null backend: resources are registered with their metadata but nothing touches GL
+  static bool Headless;
 
-  static Shader LoadShader(const char *vShaderFile, const char *fShaderFile, std::string name);
-  static Shader LoadShader(const char *vShaderFile, const char *gShaderFile ,const char *fShaderFile, std::string name);
-  static Shader GetShader(std::string name);
+  static ShaderHandle LoadShader(const char *vShaderFile, const char *fShaderFile, std::string name);
+  static ShaderHandle LoadShader(const char *vShaderFile, const char *gShaderFile ,const char *fShaderFile, std::string name);
 
-  static Texture2D LoadTexture(const char *file, bool alpha, std::string name);
-  static Texture2D GetTexture(std::string name);
+  static TextureHandle LoadTexture(const char *file, bool alpha, std::string name);
+
+  // O(1), for anything that runs per frame
+  static Shader &Get(ShaderHandle handle) { return shaders[handle.Index]; }
+  static Texture2D &Get(TextureHandle handle) { return textures[handle.Index]; }
+
+  // name lookups for loading code and tools; a miss returns the empty handle and inserts nothing
+  static ShaderHandle FindShader(const std::string &name);
+  static TextureHandle FindTexture(const std::string &name);
+  static Shader GetShader(const std::string &name) { return Get(FindShader(name)); }
+  static Texture2D GetTexture(const std::string &name) { return Get(FindTexture(name)); }
+
+  // decodes the images on the worker pool; the handles are valid right away, the textures
+  // exist once WaitTextures() returns
+  static std::vector<TextureHandle> LoadTexturesAsync(const std::vector<TextureSource> &sources);
+  // uploads every pending decode on the calling (GL) thread, in submission order
+  static void WaitTextures();
+
+  // packs the images into one RGBA texture; each source is registered under its own name with its UV rect.
+  // Images that can't be packed are loaded as separate textures and the empty handle is returned.
+  static TextureHandle LoadAtlas(const std::vector<AtlasSource> &sources, std::string name);
 
   static void Clear();
 
 private:
+  struct PendingTexture {
+    TextureSource Source;
+    TextureHandle Handle;
+    TexturePixels Image;
+    std::future<void> Decoded;
+  };
+
+  // slot 0 of each holds the empty resource
+  static std::vector<Shader> shaders;
+  static std::vector<Texture2D> textures;
+  static std::unordered_map<std::string, unsigned int> shaderNames;
+  static std::unordered_map<std::string, unsigned int> textureNames;
+  static std::deque<PendingTexture> pending;
+
   ResourceManager() {}
   
+  static ShaderHandle internShader(const std::string &name);
+  static TextureHandle internTexture(const std::string &name);
+
   static Shader loadShaderFromFile(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile = nullptr);
 
   static Texture2D loadTextureFromFile(const char *file, bool alpha);
+
+  static ThreadPool &workers();
+  // safe on any thread; goes through the baked texture cache, headless only reads the image header
+  static TexturePixels decodeImage(const char *file, int channels);
+  // GL thread only, releases the pixels
+  static Texture2D uploadTexture(TexturePixels &image, bool alpha);
 };
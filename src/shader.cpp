@@ -1,14 +1,60 @@
 #include "shader.hpp"
 
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 
+#include "hash.hpp"
+#include "render_state.hpp"
+
+// Cached program binaries, SHADER_CACHE_DIR/<key>.bin: ProgramBinaryHeader followed by Length bytes.
+// The key covers the sources and the driver, a driver update simply misses.
+const char PROGRAM_MAGIC[4] = { 'B', 'P', 'R', 'G' };
+
+struct ProgramBinaryHeader {
+  char Magic[4];
+  uint32_t Format;
+  uint64_t Key;
+  uint64_t Length;
+};
+
+ShaderStats Shader::Stats = { 0.0, 0, 0 };
+
 Shader &Shader::Use() {
-  glUseProgram(this->ID);
+  RenderState::UseProgram(this->ID);
   return *this;
 }
 
 
 void Shader::Compile(const char* vertexSource, const char* geometrySource, const char* fragmentSource) {
+  auto start = std::chrono::steady_clock::now();
+
+  uint64_t key = HASH_SEED;
+  for (const char *text : { vertexSource, geometrySource, fragmentSource }) {
+    if (text != nullptr)
+      key = HashBytes(text, std::strlen(text) + 1, key);
+  }
+  for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+    const char *text = reinterpret_cast<const char *>(glGetString(name));
+    if (text != nullptr)
+      key = HashBytes(text, std::strlen(text) + 1, key);
+  }
+  char file[64];
+  std::snprintf(file, sizeof(file), "/%016llx.bin", (unsigned long long)key);
+  std::string path = SHADER_CACHE_DIR + std::string(file);
+
+  int formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  if (formats > 0 && loadBinary(path, key)) {
+    reflectUniforms();
+    Stats.ProgramsRestored++;
+    Stats.CompileMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return;
+  }
+
   unsigned int sVertex, sFragment, sGeometry;
 
   sVertex = glCreateShader(GL_VERTEX_SHADER);
@@ -29,6 +75,8 @@ void Shader::Compile(const char* vertexSource, const char* geometrySource, const
   }
 
   this->ID = glCreateProgram();
+  if (formats > 0)
+    glProgramParameteri(this->ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
   glAttachShader(this->ID, sVertex);
   glAttachShader(this->ID, sFragment);
   if (geometrySource != nullptr) {
@@ -36,11 +84,17 @@ void Shader::Compile(const char* vertexSource, const char* geometrySource, const
   }
   glLinkProgram(this->ID);
   checkCompileErrors(this->ID, "PROGRAM");
+  reflectUniforms();
 
   glDeleteShader(sVertex);
   glDeleteShader(sFragment);
   if (geometrySource != nullptr)
     glDeleteShader(sGeometry);
+
+  if (formats > 0)
+    saveBinary(path, key);
+  Stats.ProgramsCompiled++;
+  Stats.CompileMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
 void Shader::Compile(const char* vertexSource, const char* fragmentSource) {
@@ -50,39 +104,157 @@ void Shader::Compile(const char* vertexSource, const char* fragmentSource) {
 void Shader::SetFloat(const char *name, float value, bool useShader) {
   if(useShader)
     this->Use();
-  glUniform1f(glGetUniformLocation(this->ID, name), value);
+  glUniform1f(findUniform(name), value);
 }
 
 void Shader::SetInteger(const char *name, int value, bool useShader) {
   if(useShader)
     this->Use();
-  glUniform1i(glGetUniformLocation(this->ID, name), value);
+  glUniform1i(findUniform(name), value);
 }
 
 void Shader::SetVec2(const char *name, const glm::vec2 &value, bool useShader) {
   if(useShader)
     this->Use();
-  glUniform2fv(glGetUniformLocation(this->ID, name), 1, &value[0]);
+  glUniform2fv(findUniform(name), 1, &value[0]);
 }
 
 void Shader::SetVec3(const char *name, const glm::vec3 &value, bool useShader) {
   if(useShader)
     this->Use();
-  glUniform3fv(glGetUniformLocation(this->ID, name), 1, &value[0]);
+  glUniform3fv(findUniform(name), 1, &value[0]);
 }
 
 void Shader::SetVec4(const char *name, const glm::vec4 &value, bool useShader) {
   if(useShader)
     this->Use();
-  glUniform4fv(glGetUniformLocation(this->ID, name), 1, &value[0]);
+  glUniform4fv(findUniform(name), 1, &value[0]);
 }
 
 void Shader::SetMat4(const char *name, const glm::mat4 &value, bool useShader) {
   if(useShader)
     this->Use();
-  glUniformMatrix4fv(glGetUniformLocation(this->ID, name), 1, false, glm::value_ptr(value));
+  glUniformMatrix4fv(findUniform(name), 1, false, glm::value_ptr(value));
+}
+
+void Shader::Set(UniformHandle<float> uniform, float value) {
+  glUniform1f(uniform.Location, value);
+}
+
+void Shader::Set(UniformHandle<int> uniform, int value) {
+  glUniform1i(uniform.Location, value);
+}
+
+void Shader::Set(UniformHandle<glm::vec2> uniform, const glm::vec2 &value) {
+  glUniform2fv(uniform.Location, 1, &value[0]);
+}
+
+void Shader::Set(UniformHandle<glm::vec3> uniform, const glm::vec3 &value) {
+  glUniform3fv(uniform.Location, 1, &value[0]);
+}
+
+void Shader::Set(UniformHandle<glm::vec4> uniform, const glm::vec4 &value) {
+  glUniform4fv(uniform.Location, 1, &value[0]);
+}
+
+void Shader::Set(UniformHandle<glm::mat4> uniform, const glm::mat4 &value) {
+  glUniformMatrix4fv(uniform.Location, 1, false, glm::value_ptr(value));
 }
 
+bool Shader::loadBinary(const std::string &path, uint64_t key) {
+  std::ifstream in(path, std::ios::binary);
+  ProgramBinaryHeader header;
+  if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) || std::memcmp(header.Magic, PROGRAM_MAGIC, sizeof(PROGRAM_MAGIC)) != 0
+      || header.Key != key)
+    return false;
+
+  // a truncated or padded file is corrupt; don't hand the driver a length the file can't back
+  std::error_code error;
+  uintmax_t size = std::filesystem::file_size(path, error);
+  if (error || header.Length == 0 || size != sizeof(header) + (uintmax_t)header.Length)
+    return false;
+
+  std::vector<char> binary(header.Length);
+  if (!in.read(binary.data(), binary.size()))
+    return false;
+
+  // the driver may still reject a binary it produced itself, e.g. after an update with the same version string
+  this->ID = glCreateProgram();
+  glProgramBinary(this->ID, header.Format, binary.data(), binary.size());
+  int success;
+  glGetProgramiv(this->ID, GL_LINK_STATUS, &success);
+  if (!success) {
+    glDeleteProgram(this->ID);
+    this->ID = 0;
+    return false;
+  }
+  return true;
+}
+
+void Shader::saveBinary(const std::string &path, uint64_t key) {
+  int success, length;
+  glGetProgramiv(this->ID, GL_LINK_STATUS, &success);
+  glGetProgramiv(this->ID, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (!success || length <= 0)
+    return;
+
+  ProgramBinaryHeader header;
+  std::vector<char> binary(length);
+  GLenum format;
+  glGetProgramBinary(this->ID, length, &length, &format, binary.data());
+  std::memcpy(header.Magic, PROGRAM_MAGIC, sizeof(PROGRAM_MAGIC));
+  header.Format = format;
+  header.Key = key;
+  header.Length = length;
+
+  std::error_code error;
+  std::filesystem::create_directories(SHADER_CACHE_DIR, error);
+
+  // written aside and renamed into place, so a crash mid-write never leaves a corrupt binary
+  std::string temp = path + ".tmp";
+  {
+    std::ofstream out(temp, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(binary.data(), length);
+    if (!out) {
+      std::cerr << "Error: Failed to write shader cache " << temp << "\n";
+      std::remove(temp.c_str());
+      return;
+    }
+  }
+  std::rename(temp.c_str(), path.c_str());
+}
+
+void Shader::reflectUniforms() {
+  uniforms.clear();
+
+  int count, maxLength;
+  glGetProgramiv(this->ID, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(this->ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+  std::vector<char> name(maxLength > 0 ? maxLength : 1);
+  for (int i = 0; i < count; i++) {
+    int length, size;
+    unsigned int type;
+    glGetActiveUniform(this->ID, i, name.size(), &length, &size, &type, name.data());
+    int location = glGetUniformLocation(this->ID, name.data());
+    if (location < 0)
+      continue;
+
+    // arrays are reported as "name[0]", but callers look them up by their plain name
+    std::string key(name.data(), length);
+    if (key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0)
+      key.resize(key.size() - 3);
+    uniforms.emplace_back(key, location);
+  }
+}
+
+int Shader::findUniform(const char *name) const {
+  for (const auto &uniform : uniforms)
+    if (std::strcmp(uniform.first.c_str(), name) == 0)
+      return uniform.second;
+  return -1;
+}
 
 void Shader::checkCompileErrors(unsigned int object, std::string type) {
   int success;
@@ -1,16 +1,34 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+const char SHADER_CACHE_DIR[] = "cache/shaders";
+
+struct ShaderStats {
+  double CompileMilliseconds;
+  unsigned int ProgramsRestored;
+  unsigned int ProgramsCompiled;
+};
+
+// a uniform location resolved once at compile time; the type picks the matching Shader::Set overload
+template <typename T>
+struct UniformHandle {
+  int Location = -1;
+};
+
 class Shader {
 public:
   unsigned int ID;
+  // startup cost of every Compile() so far
+  static ShaderStats Stats;
 
-  Shader () { }
+  Shader () : ID(0) { }
 
   Shader &Use();
   void Compile(const char *vertexSource, const char *fragmentSource);
@@ -22,6 +40,22 @@ public:
   void SetVec4(const char *name, const glm::vec4 &value, bool useShader = false);
   void SetMat4(const char *name, const glm::mat4 &value, bool useShader = false);
 
+  template <typename T>
+  UniformHandle<T> Uniform(const char *name) const { return UniformHandle<T>{ findUniform(name) }; }
+
+  void Set(UniformHandle<float> uniform, float value);
+  void Set(UniformHandle<int> uniform, int value);
+  void Set(UniformHandle<glm::vec2> uniform, const glm::vec2 &value);
+  void Set(UniformHandle<glm::vec3> uniform, const glm::vec3 &value);
+  void Set(UniformHandle<glm::vec4> uniform, const glm::vec4 &value);
+  void Set(UniformHandle<glm::mat4> uniform, const glm::mat4 &value);
+
 private:
+  std::vector<std::pair<std::string, int>> uniforms;
+
+  bool loadBinary(const std::string &path, uint64_t key);
+  void saveBinary(const std::string &path, uint64_t key);
+  void reflectUniforms();
+  int findUniform(const char *name) const;
   void checkCompileErrors(unsigned int object, std::string type);
 };
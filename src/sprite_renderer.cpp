@@ -1,12 +1,25 @@
 #include "sprite_renderer.hpp"
 
-SpriteRenderer::SpriteRenderer(const Shader &shader) {
+#include <cmath>
+#include <cstddef>
+
+#include "render_state.hpp"
+
+SpriteRenderer::SpriteRenderer(const Shader &shader, const Shader &instanceShader) : batchCapacity(0), batchTexture(0) {
   this->shader = shader;
+  this->instanceShader = instanceShader;
+  this->modelUniform = shader.Uniform<glm::mat4>("model");
+  this->colorUniform = shader.Uniform<glm::vec3>("spriteColor");
+  this->uvUniform = shader.Uniform<glm::vec4>("uvRect");
   this->initRenderData();
 }
 
 SpriteRenderer::~SpriteRenderer() {
+  RenderState::ForgetVertexArray(this->quadVAO);
+  RenderState::ForgetVertexArray(this->batchVAO);
   glDeleteVertexArrays(1, &this->quadVAO);
+  glDeleteVertexArrays(1, &this->batchVAO);
+  glDeleteBuffers(1, &this->batchVBO);
 }
 
 void SpriteRenderer::initRenderData() {
@@ -28,11 +41,24 @@ void SpriteRenderer::initRenderData() {
   glBindBuffer(GL_ARRAY_BUFFER, VBO);
   glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-  glBindVertexArray(quadVAO);
+  RenderState::BindVertexArray(quadVAO);
   glEnableVertexAttribArray(0);
   glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+  // the immediate path has no per-vertex color, so attribute 1 reads this constant
+  glVertexAttrib3f(1, 1.0f, 1.0f, 1.0f);
+
+  glGenVertexArrays(1, &batchVAO);
+  glGenBuffers(1, &batchVBO);
+
+  RenderState::BindVertexArray(batchVAO);
+  glBindBuffer(GL_ARRAY_BUFFER, batchVBO);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, PosTex));
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, Color));
+
   glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
+  RenderState::BindVertexArray(0);
 }
 
 void SpriteRenderer::DrawSprite(const Texture2D &texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color) {
@@ -44,13 +70,104 @@ void SpriteRenderer::DrawSprite(const Texture2D &texture, glm::vec2 position, gl
   model = glm::translate(model, glm::vec3(-0.5 * size.x, -0.5 * size.y, 0.0));
   model = glm::scale(model, glm::vec3(size, 1.0f));
 
-  shader.SetMat4("model", model);
-  shader.SetVec3("spriteColor", color);
+  shader.Set(modelUniform, model);
+  shader.Set(colorUniform, color);
+  shader.Set(uvUniform, texture.UV);
 
-  glActiveTexture(GL_TEXTURE0);
+  RenderState::ActiveTexture(GL_TEXTURE0);
   texture.Bind();
 
-  glBindVertexArray(quadVAO);
+  RenderState::BindVertexArray(quadVAO);
   glDrawArrays(GL_TRIANGLES, 0, 6);
-  glBindVertexArray(0);
+}
+
+void SpriteRenderer::Begin() {
+  batchVertices.clear();
+  batchTexture = 0;
+
+  shader.Use();
+  shader.Set(modelUniform, glm::mat4(1.0f));
+  shader.Set(colorUniform, glm::vec3(1.0f));
+  shader.Set(uvUniform, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+  RenderState::ActiveTexture(GL_TEXTURE0);
+}
+
+void SpriteRenderer::Submit(const Texture2D &texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color) {
+  if (texture.ID != batchTexture) {
+    flush();
+    batchTexture = texture.ID;
+  }
+
+  glm::vec2 corners[4] = {
+    glm::vec2(0.0f, 0.0f),
+    glm::vec2(1.0f, 0.0f),
+    glm::vec2(0.0f, 1.0f),
+    glm::vec2(1.0f, 1.0f),
+  };
+  glm::vec2 points[4];
+
+  if (rotate == 0.0f) {
+    for (unsigned int i = 0; i < 4; i++)
+      points[i] = position + corners[i] * size;
+  }
+  else {
+    float s = std::sin(glm::radians(rotate));
+    float c = std::cos(glm::radians(rotate));
+    glm::vec2 half = 0.5f * size;
+    glm::vec2 center = position + half;
+    for (unsigned int i = 0; i < 4; i++) {
+      glm::vec2 local = corners[i] * size - half;
+      points[i] = center + glm::vec2(c * local.x - s * local.y, s * local.x + c * local.y);
+    }
+  }
+
+  // same winding as the immediate quad
+  const unsigned int order[6] = { 2, 1, 0, 2, 3, 1 };
+  for (unsigned int i : order)
+    batchVertices.push_back({ glm::vec4(points[i], glm::mix(glm::vec2(texture.UV), glm::vec2(texture.UV.z, texture.UV.w), corners[i])), color });
+}
+
+void SpriteRenderer::End() {
+  flush();
+}
+
+void SpriteRenderer::Flush() {
+  flush();
+}
+
+void SpriteRenderer::DrawInstanced(const BrickInstances &instances, const Texture2D &texture) {
+  flush();
+  if (instances.Count == 0)
+    return;
+
+  instanceShader.Use();
+  RenderState::ActiveTexture(GL_TEXTURE0);
+  texture.Bind();
+
+  RenderState::BindVertexArray(instances.VAO);
+  glDrawArraysInstanced(GL_TRIANGLES, 0, 6, instances.Count);
+
+  // hand the pipeline back to the batch
+  shader.Use();
+  batchTexture = 0;
+}
+
+void SpriteRenderer::flush() {
+  if (batchVertices.empty())
+    return;
+
+  RenderState::BindVertexArray(batchVAO);
+  glBindBuffer(GL_ARRAY_BUFFER, batchVBO);
+
+  unsigned int count = batchVertices.size();
+  if (count > batchCapacity)
+    batchCapacity = count * 2;
+  // orphan the previous storage so the driver doesn't stall on an in-flight draw
+  glBufferData(GL_ARRAY_BUFFER, batchCapacity * sizeof(SpriteVertex), nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(SpriteVertex), batchVertices.data());
+
+  RenderState::BindTexture(batchTexture);
+  glDrawArrays(GL_TRIANGLES, 0, count);
+
+  batchVertices.clear();
 }
@@ -1,18 +1,45 @@
 #pragma once
 
+#include <vector>
+
 #include "shader.hpp"
 #include "texture.hpp"
+#include "brick_instances.hpp"
+
+struct SpriteVertex {
+  glm::vec4 PosTex;
+  glm::vec3 Color;
+};
 
 class SpriteRenderer {
 public:
-  SpriteRenderer(const Shader &shader);
+  SpriteRenderer(const Shader &shader, const Shader &instanceShader);
   ~SpriteRenderer();
 
   void DrawSprite(const Texture2D &texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
 
+  // batched submission: sprites between Begin() and End() are flushed with one draw per texture change
+  void Begin();
+  void Submit(const Texture2D &texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+  void End();
+  // draws what is queued so far without ending the batch, e.g. at a GPU timing boundary
+  void Flush();
+
+  // all instances must sample from the same texture, i.e. the sprite atlas
+  void DrawInstanced(const BrickInstances &instances, const Texture2D &texture);
+
 private:
   Shader shader;
+  Shader instanceShader;
+  UniformHandle<glm::mat4> modelUniform;
+  UniformHandle<glm::vec3> colorUniform;
+  UniformHandle<glm::vec4> uvUniform;
   unsigned int quadVAO;
+  unsigned int batchVAO, batchVBO;
+  unsigned int batchCapacity;
+  unsigned int batchTexture;
+  std::vector<SpriteVertex> batchVertices;
 
   void initRenderData();
+  void flush();
 };
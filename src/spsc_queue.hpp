@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free ring of up to N items between exactly one producer and one consumer thread. Head and
+// tail count forever and wrap through the unsigned range; N must be a power of two.
+template <typename T, unsigned int N>
+class SpscQueue {
+  static_assert(N && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+  SpscQueue() : head(0), tail(0) { }
+
+  // false when the queue is full; the item is dropped
+  bool Push(const T &item) {
+    unsigned int h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == N)
+      return false;
+    items[h & (N - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool Pop(T &item) {
+    unsigned int t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire))
+      return false;
+    item = items[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  T items[N];
+  alignas(64) std::atomic<unsigned int> head;
+  alignas(64) std::atomic<unsigned int> tail;
+};
@@ -1,26 +1,43 @@
 #include "texture.hpp"
 
+#include <algorithm>
 #include <iostream>
 
-Texture2D::Texture2D() : Width(0), Height(0), Internal_Format(GL_RGB), Image_Format(GL_RGB), Wrap_S(GL_REPEAT), Wrap_T(GL_REPEAT), Filter_Min(GL_LINEAR), Filter_Mag(GL_LINEAR) {
-  glGenTextures(1, &this->ID);
+#include "render_state.hpp"
+
+Texture2D::Texture2D() : ID(0), Width(0), Height(0), Internal_Format(GL_RGB), Image_Format(GL_RGB), Wrap_S(GL_REPEAT), Wrap_T(GL_REPEAT), Filter_Min(GL_LINEAR), Filter_Mag(GL_LINEAR), UV(0.0f, 0.0f, 1.0f, 1.0f) {
 }
 
-void Texture2D::Generate(unsigned int width, unsigned int height, unsigned char* data) {
+void Texture2D::Generate(unsigned int width, unsigned int height, const unsigned char* data, unsigned int levels) {
   this->Width = width;
   this->Height = height;
 
-  glBindTexture(GL_TEXTURE_2D, this->ID);
-  glTexImage2D(GL_TEXTURE_2D, 0, this->Internal_Format, width, height, 0, this->Image_Format, GL_UNSIGNED_BYTE, data);
+  // names are created on first upload so textures can exist without a GL context
+  if (this->ID == 0)
+    glGenTextures(1, &this->ID);
+  RenderState::BindTexture(this->ID);
+
+  // decoded rows are tightly packed, which breaks the default 4 byte alignment for odd RGB widths
+  unsigned int channels = this->Image_Format == GL_RGBA ? 4 : this->Image_Format == GL_RGB ? 3 : this->Image_Format == GL_RG ? 2 : 1;
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  for (unsigned int level = 0; level < levels; level++) {
+    glTexImage2D(GL_TEXTURE_2D, level, this->Internal_Format, width, height, 0, this->Image_Format, GL_UNSIGNED_BYTE, data);
+    if (data)
+      data += (size_t)width * height * channels;
+    width = std::max(1u, width / 2);
+    height = std::max(1u, height / 2);
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
 
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, this->Wrap_S);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, this->Wrap_T);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->Filter_Min);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, this->Filter_Mag);
 
-  glBindTexture(GL_TEXTURE_2D, 0);
+  RenderState::BindTexture(0);
 }
 
 void Texture2D::Bind() const {
-  glBindTexture(GL_TEXTURE_2D, this->ID);
+  RenderState::BindTexture(this->ID);
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glad/glad.h>
+#include <glm/glm.hpp>
 
 class Texture2D {
 public:
@@ -12,9 +13,12 @@ public:
   unsigned int Wrap_T;
   unsigned int Filter_Min;
   unsigned int Filter_Mag;
+  // sub-rectangle (u0, v0, u1, v1) inside ID; the whole texture unless it lives in an atlas
+  glm::vec4 UV;
 
   Texture2D();
 
-  void Generate(unsigned int width, unsigned int height, unsigned char* data);
+  // data may hold a mip chain: levels images, each half the size of the last, tightly packed
+  void Generate(unsigned int width, unsigned int height, const unsigned char* data, unsigned int levels = 1);
   void Bind() const;
 };
@@ -0,0 +1,47 @@
+#include "texture_atlas.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+AtlasPacker::AtlasPacker(unsigned int maxWidth, unsigned int padding) : Width(0), Height(0), maxWidth(maxWidth), padding(padding) { }
+
+bool AtlasPacker::Pack(const std::vector<glm::uvec2> &sizes, std::vector<AtlasRect> &rects) {
+  Width = 0;
+  Height = 0;
+  rects.assign(sizes.size(), AtlasRect{ 0, 0, 0, 0 });
+
+  std::vector<unsigned int> order(sizes.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&sizes](unsigned int a, unsigned int b) {
+    if (sizes[a].y != sizes[b].y)
+      return sizes[a].y > sizes[b].y;
+    if (sizes[a].x != sizes[b].x)
+      return sizes[a].x > sizes[b].x;
+    return a < b;
+  });
+
+  unsigned int shelfX = 0, shelfY = 0, shelfHeight = 0;
+  for (unsigned int i : order) {
+    unsigned int w = sizes[i].x + 2 * padding;
+    unsigned int h = sizes[i].y + 2 * padding;
+    // leave nothing half placed for a caller that ignores the result
+    if (w > maxWidth) {
+      rects.assign(sizes.size(), AtlasRect{ 0, 0, 0, 0 });
+      Width = Height = 0;
+      return false;
+    }
+
+    if (shelfX + w > maxWidth) {
+      shelfY += shelfHeight;
+      shelfX = 0;
+      shelfHeight = 0;
+    }
+
+    rects[i] = { shelfX + padding, shelfY + padding, sizes[i].x, sizes[i].y };
+    shelfX += w;
+    shelfHeight = std::max(shelfHeight, h);
+    Width = std::max(Width, shelfX);
+  }
+  Height = shelfY + shelfHeight;
+  return true;
+}
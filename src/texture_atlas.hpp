@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+struct AtlasRect {
+  unsigned int X, Y;
+  unsigned int Width, Height;
+};
+
+// Shelf packer for the sprite atlas. Pure CPU and fully deterministic: images are placed
+// tallest first, ties broken by width and then by input index, so the same inputs always
+// produce the same layout.
+class AtlasPacker {
+public:
+  unsigned int Width, Height;
+
+  AtlasPacker(unsigned int maxWidth, unsigned int padding = 2);
+
+  // rects[i] receives the placement of sizes[i], excluding padding; on failure (an image wider
+  // than maxWidth) every rect and the atlas size are zero
+  bool Pack(const std::vector<glm::uvec2> &sizes, std::vector<AtlasRect> &rects);
+
+private:
+  unsigned int maxWidth;
+  unsigned int padding;
+};
@@ -0,0 +1,181 @@
+#include "texture_cache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stb_image.h>
+
+#include "hash.hpp"
+
+static std::shared_ptr<const void> mapFile(const char *path, size_t &size) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return nullptr;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    close(fd);
+    return nullptr;
+  }
+
+  void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED)
+    return nullptr;
+
+  size = info.st_size;
+  return std::shared_ptr<const void>(mapped, [size](const void *data) { munmap(const_cast<void *>(data), size); });
+}
+
+static std::string cachePath(uint64_t hash, int channels) {
+  char name[64];
+  std::snprintf(name, sizeof(name), "/%016llx-%d.btex", (unsigned long long)hash, channels);
+  return TEXTURE_CACHE_DIR + std::string(name);
+}
+
+size_t MipChainSize(unsigned int width, unsigned int height, unsigned int channels, unsigned int levels) {
+  size_t size = 0;
+  for (unsigned int level = 0; level < levels; level++) {
+    size += (size_t)width * height * channels;
+    width = std::max(1u, width / 2);
+    height = std::max(1u, height / 2);
+  }
+  return size;
+}
+
+// levels in the full chain of a width x height image, down to 1x1
+static unsigned int mipLevels(unsigned int width, unsigned int height) {
+  unsigned int levels = 1;
+  for (unsigned int extent = std::max(width, height); extent > 1; extent /= 2)
+    levels++;
+  return levels;
+}
+
+static bool loadBlob(const std::string &path, uint64_t hash, int channels, TexturePixels &pixels) {
+  size_t size;
+  std::shared_ptr<const void> blob = mapFile(path.c_str(), size);
+  if (!blob || size < sizeof(TextureBlobHeader))
+    return false;
+
+  TextureBlobHeader header;
+  std::memcpy(&header, blob.get(), sizeof(header));
+  if (std::memcmp(header.Magic, TEXTURE_MAGIC, sizeof(TEXTURE_MAGIC)) != 0 || header.Version != TEXTURE_VERSION
+      || header.SourceHash != hash)
+    return false;
+  // the callers size their reads from these, so anything stb could not have produced is refused
+  if (header.Width == 0 || header.Height == 0 || header.Channels == 0 || header.Channels > 4
+      || (channels != 0 && header.Channels != channels)
+      || header.Levels == 0 || header.Levels > mipLevels(header.Width, header.Height)
+      || size != sizeof(header) + MipChainSize(header.Width, header.Height, header.Channels, header.Levels))
+    return false;
+
+  pixels.Width = header.Width;
+  pixels.Height = header.Height;
+  pixels.Channels = header.Channels;
+  pixels.Levels = header.Levels;
+  pixels.Data = static_cast<const unsigned char *>(blob.get()) + sizeof(header);
+  pixels.Storage = blob;
+  return true;
+}
+
+// box filters each level from the one above it; odd edges reuse their last row or column
+static void buildMips(std::vector<unsigned char> &chain, unsigned int width, unsigned int height, unsigned int channels, unsigned int levels) {
+  unsigned char *src = chain.data();
+  for (unsigned int level = 1; level < levels; level++) {
+    unsigned int w = std::max(1u, width / 2), h = std::max(1u, height / 2);
+    unsigned char *dst = src + (size_t)width * height * channels;
+    for (unsigned int y = 0; y < h; y++) {
+      unsigned int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+      for (unsigned int x = 0; x < w; x++) {
+        unsigned int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+        for (unsigned int c = 0; c < channels; c++) {
+          unsigned int sum = src[((size_t)y0 * width + x0) * channels + c] + src[((size_t)y0 * width + x1) * channels + c]
+                           + src[((size_t)y1 * width + x0) * channels + c] + src[((size_t)y1 * width + x1) * channels + c];
+          dst[((size_t)y * w + x) * channels + c] = (sum + 2) / 4;
+        }
+      }
+    }
+    src = dst;
+    width = w;
+    height = h;
+  }
+}
+
+static void writeBlob(const std::string &path, const TextureBlobHeader &header, const std::vector<unsigned char> &chain) {
+  static std::atomic<unsigned int> counter(0);
+
+  std::error_code error;
+  std::filesystem::create_directories(TEXTURE_CACHE_DIR, error);
+
+  // written aside and renamed into place so a concurrent reader never maps half a blob
+  std::string temp = path + ".tmp" + std::to_string(counter++);
+  {
+    std::ofstream out(temp, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(chain.data()), chain.size());
+    if (!out) {
+      std::cerr << "Error: Failed to write texture cache " << temp << "\n";
+      std::remove(temp.c_str());
+      return;
+    }
+  }
+  std::rename(temp.c_str(), path.c_str());
+}
+
+bool LoadTexturePixels(const char *file, int channels, TexturePixels &pixels) {
+  size_t size;
+  std::shared_ptr<const void> source = mapFile(file, size);
+  if (!source) {
+    std::cerr << "Error: Failed to open texture " << file << "\n";
+    return false;
+  }
+
+  const unsigned char *bytes = static_cast<const unsigned char *>(source.get());
+  uint64_t hash = HashBytes(bytes, size);
+  std::string path = cachePath(hash, channels);
+  if (loadBlob(path, hash, channels, pixels))
+    return true;
+
+  int width, height, stored;
+  unsigned char *decoded = stbi_load_from_memory(bytes, size, &width, &height, &stored, channels);
+  if (!decoded) {
+    std::cerr << "Error: Failed to decode texture " << file << ": " << stbi_failure_reason() << "\n";
+    return false;
+  }
+
+  TextureBlobHeader header;
+  std::memcpy(header.Magic, TEXTURE_MAGIC, sizeof(TEXTURE_MAGIC));
+  header.Version = TEXTURE_VERSION;
+  header.Channels = channels != 0 ? channels : stored;
+  header.Width = width;
+  header.Height = height;
+  header.Levels = mipLevels(width, height);
+  header.Reserved = 0;
+  header.SourceHash = hash;
+
+  auto chain = std::make_shared<std::vector<unsigned char>>(MipChainSize(width, height, header.Channels, header.Levels));
+  std::memcpy(chain->data(), decoded, (size_t)width * height * header.Channels);
+  stbi_image_free(decoded);
+  buildMips(*chain, width, height, header.Channels, header.Levels);
+  writeBlob(path, header, *chain);
+
+  pixels.Width = width;
+  pixels.Height = height;
+  pixels.Channels = header.Channels;
+  pixels.Levels = header.Levels;
+  pixels.Data = chain->data();
+  pixels.Storage = chain;
+  return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Baked textures live in TEXTURE_CACHE_DIR as <source hash>-<channels>.btex, host byte order:
+//   TextureBlobHeader, then every mip level from the full image down to 1x1, tightly packed.
+// The name comes from the contents of the source image, so an edited image simply misses.
+const char TEXTURE_CACHE_DIR[] = "cache/textures";
+const char TEXTURE_MAGIC[4] = { 'B', 'T', 'E', 'X' };
+const uint16_t TEXTURE_VERSION = 1;
+
+struct TextureBlobHeader {
+  char Magic[4];
+  uint16_t Version;
+  uint16_t Channels;
+  uint32_t Width, Height;
+  uint32_t Levels;
+  uint32_t Reserved;
+  uint64_t SourceHash;
+};
+
+// one image and its mip chain, mapped from the cache or freshly decoded
+struct TexturePixels {
+  int Width = 0, Height = 0, Channels = 0;
+  unsigned int Levels = 0;
+  const unsigned char *Data = nullptr;
+  // keeps the mapping or the decoded buffer alive
+  std::shared_ptr<const void> Storage;
+};
+
+// bytes taken by levels mips of a width x height image; each level halves, rounding down, to at least 1
+size_t MipChainSize(unsigned int width, unsigned int height, unsigned int channels, unsigned int levels);
+
+// channels is passed on to stbi_load (0 keeps the image's own count). Maps the baked blob when it
+// matches the current contents of file, otherwise decodes with stb and bakes the blob for the next
+// run. Thread safe; errors go to std::cerr.
+bool LoadTexturePixels(const char *file, int channels, TexturePixels &pixels);
@@ -0,0 +1,49 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threads) : stopping(false) {
+  if (threads == 0)
+    // hardware_concurrency() may be 0 when unknown; leave one core to the calling thread
+    threads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+  for (unsigned int i = 0; i < threads; i++)
+    workers.emplace_back(&ThreadPool::run, this);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (std::thread &worker : workers)
+    worker.join();
+}
+
+std::future<void> ThreadPool::Submit(std::function<void()> job) {
+  std::packaged_task<void()> task(std::move(job));
+  std::future<void> done = task.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.push_back(std::move(task));
+  }
+  wake.notify_one();
+  return done;
+}
+
+void ThreadPool::run() {
+  for (;;) {
+    std::packaged_task<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+      // queued jobs still run on shutdown, somebody may be waiting on their futures
+      if (jobs.empty())
+        return;
+      task = std::move(jobs.front());
+      jobs.pop_front();
+    }
+    task();
+  }
+}
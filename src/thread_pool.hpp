@@ -0,0 +1,30 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads draining a FIFO of jobs. Jobs must not touch GL, the context
+// belongs to the main thread.
+class ThreadPool {
+public:
+  // 0 picks one worker per hardware thread, leaving one for the caller
+  ThreadPool(unsigned int threads = 0);
+  ~ThreadPool();
+
+  std::future<void> Submit(std::function<void()> job);
+  unsigned int Size() const { return workers.size(); }
+
+private:
+  std::vector<std::thread> workers;
+  std::deque<std::packaged_task<void()>> jobs;
+  std::mutex mutex;
+  std::condition_variable wake;
+  bool stopping;
+
+  void run();
+};
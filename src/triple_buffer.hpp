@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free hand-off of the latest value from one writer thread to one reader thread. The writer
+// fills Back() and Publish() swaps it with the middle slot; Acquire() swaps the middle slot into
+// Front() if something new arrived. Neither side ever waits on the other: values the reader was
+// too slow to pick up are overwritten, and slots are reused, so the writer fills in every field.
+template <typename T>
+class TripleBuffer {
+public:
+  TripleBuffer() : back(0), front(1), middle(2) { }
+
+  T &Back() { return slots[back]; }
+  void Publish() {
+    back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+  }
+
+  // false (and Front() unchanged) when nothing was published since the last call
+  bool Acquire() {
+    if (!(middle.load(std::memory_order_relaxed) & FRESH))
+      return false;
+    front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+    return true;
+  }
+  const T &Front() const { return slots[front]; }
+
+private:
+  static const unsigned int INDEX = 3, FRESH = 4;
+
+  T slots[3];
+  // each side owns one slot index; the shared one sits on its own cache line
+  unsigned int back, front;
+  alignas(64) std::atomic<unsigned int> middle;
+};
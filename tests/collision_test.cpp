@@ -0,0 +1,103 @@
+#include "test.hpp"
+
+#include <cmath>
+
+#include "collision.hpp"
+
+static bool near(float a, float b, float epsilon = 1e-3f) {
+  return std::fabs(a - b) <= epsilon;
+}
+
+TEST(SweepHitsFace) {
+  SweepHit hit;
+  CHECK(SweepCircleAABB(glm::vec2(5.0f, 20.0f), 5.0f, glm::vec2(0.0f, -10.0f), glm::vec2(0.0f), glm::vec2(10.0f), hit));
+  CHECK(near(hit.Time, 0.5f));
+  CHECK(hit.Normal == glm::vec2(0.0f, 1.0f));
+}
+
+TEST(SweepFromCornerRegion) {
+  // inside the box grown by the radius, but not touching the box itself
+  SweepHit hit;
+  glm::vec2 center(14.0f, 14.0f);
+  CHECK(SweepCircleAABB(center, 5.0f, glm::vec2(-2.0f, -2.0f), glm::vec2(0.0f), glm::vec2(10.0f), hit));
+  CHECK(near(hit.Time, (16.0f - std::sqrt(200.0f)) / 8.0f));
+  CHECK(near(hit.Normal.x, std::sqrt(0.5f)) && near(hit.Normal.y, std::sqrt(0.5f)));
+
+  // moving past the corner or away from it
+  CHECK(!SweepCircleAABB(center, 5.0f, glm::vec2(2.0f, -2.0f), glm::vec2(0.0f), glm::vec2(10.0f), hit));
+  CHECK(!SweepCircleAABB(center, 5.0f, glm::vec2(1.0f, 1.0f), glm::vec2(0.0f), glm::vec2(10.0f), hit));
+}
+
+TEST(SweepDoesNotTunnel) {
+  SweepHit hit;
+  // a step long enough to end on the far side of the box
+  CHECK(SweepCircleAABB(glm::vec2(14.0f, 14.0f), 5.0f, glm::vec2(-30.0f, -30.0f), glm::vec2(0.0f), glm::vec2(10.0f), hit));
+  CHECK(near(hit.Time, (240.0f - std::sqrt(45000.0f)) / 1800.0f));
+  CHECK(hit.Normal.x > 0.0f && hit.Normal.y > 0.0f);
+
+  CHECK(SweepCircleAABB(glm::vec2(5.0f, 100.0f), 2.0f, glm::vec2(0.0f, -200.0f), glm::vec2(0.0f), glm::vec2(10.0f), hit));
+  CHECK(near(hit.Time, (100.0f - 12.0f) / 200.0f));
+  CHECK(hit.Normal == glm::vec2(0.0f, 1.0f));
+}
+
+// Game::CheckCollision's test, sqrt included
+static bool checkCollision(glm::vec2 center, float radius, glm::vec2 position, glm::vec2 size) {
+  glm::vec2 half(size / 2.0f);
+  glm::vec2 aabbCenter(position + half);
+  glm::vec2 closest = aabbCenter + glm::clamp(center - aabbCenter, -half, half);
+  return glm::length(closest - center) <= radius;
+}
+
+TEST(CollideMatchesCheckCollision) {
+  // coordinates on a half-unit grid keep every distance exact, so the sqrt can't flip a result
+  unsigned int seed = 7;
+  auto grid = [&seed](unsigned int range) {
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) % (range * 2) * 0.5f;
+  };
+
+  float x[64], y[64], w[64], h[64];
+  for (unsigned int round = 0; round < 200; round++) {
+    glm::vec2 center(grid(100), grid(100));
+    float radius = 12.5f;
+    // every count from a single scalar box up to full AVX2, SSE2 and scalar mixes
+    for (unsigned int count = 1; count <= 64; count++) {
+      for (unsigned int i = 0; i < count; i++) {
+        x[i] = grid(100);
+        y[i] = grid(100);
+        w[i] = grid(30) + 0.5f;
+        h[i] = grid(30) + 0.5f;
+      }
+      CircleHits hits = CollideCircleAABBs(center, radius, x, y, w, h, count);
+
+      uint64_t expected = 0;
+      for (unsigned int i = 0; i < count; i++)
+        expected |= uint64_t(checkCollision(center, radius, glm::vec2(x[i], y[i]), glm::vec2(w[i], h[i]))) << i;
+      CHECK(hits.Mask == expected);
+      CHECK((hits.Nearest >= 0) == (expected != 0));
+    }
+  }
+}
+
+TEST(CollideCountsTouchingBoxes) {
+  // every box touches the circle exactly at one edge; counts cover partial lane groups
+  const unsigned int COUNTS[] = { 1, 3, 4, 5, 7, 8, 9, 12, 13, 15, 17, 63, 64 };
+  glm::vec2 center(50.0f, 50.0f);
+  float x[64], y[64], w[64], h[64];
+  for (unsigned int i = 0; i < 64; i++) {
+    // alternate left, right, top and bottom neighbours
+    glm::vec2 offsets[4] = { { 35.0f, 45.0f }, { 55.0f, 45.0f }, { 45.0f, 35.0f }, { 45.0f, 55.0f } };
+    x[i] = offsets[i % 4].x;
+    y[i] = offsets[i % 4].y;
+    w[i] = h[i] = 10.0f;
+  }
+  for (unsigned int count : COUNTS) {
+    CircleHits hits = CollideCircleAABBs(center, 5.0f, x, y, w, h, count);
+    CHECK(hits.Mask == (count == 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1));
+    CHECK(hits.Nearest == 0 && hits.NearestDistance2 == 25.0f);
+    // a hair smaller and none of them touch
+    CHECK(CollideCircleAABBs(center, 4.99f, x, y, w, h, count).Mask == 0);
+  }
+  for (unsigned int i = 0; i < 4; i++)
+    CHECK(checkCollision(center, 5.0f, glm::vec2(x[i], y[i]), glm::vec2(w[i], h[i])));
+}
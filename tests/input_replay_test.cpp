@@ -0,0 +1,126 @@
+#include "test.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <GLFW/glfw3.h>
+
+#include "game.hpp"
+#include "input_replay.hpp"
+#include "resource_manager.hpp"
+
+static const char *REPLAY_FILE = "/tmp/breakout_test_replay.brpl";
+
+// a small LCG, so every run feeds the same key changes
+static unsigned int nextRandom(unsigned int &state) {
+  state = state * 1664525u + 1013904223u;
+  return state >> 8;
+}
+
+TEST(ReplayRoundTripsKeys) {
+  const unsigned int TICKS = 20000;
+  std::vector<std::vector<bool>> recorded;
+  bool keys[REPLAY_KEYS] = { };
+  unsigned int random = 1;
+
+  InputRecorder recorder;
+  recorder.Begin(1.0f / 240.0f, 0);
+  for (unsigned int tick = 0; tick < TICKS; tick++) {
+    // bursts of changes separated by quiet stretches of up to 1000 ticks, so gaps need
+    // varints of one, two and three bytes; key 1023 is the highest the format can carry
+    if ((tick / 1000) % 2 == 0 || tick % 997 == 0) {
+      for (unsigned int change = nextRandom(random) % 4; change > 0; change--) {
+        unsigned int key = nextRandom(random) % REPLAY_KEYS;
+        keys[key] = !keys[key];
+      }
+      if (tick % 300 == 0)
+        keys[REPLAY_KEYS - 1] = !keys[REPLAY_KEYS - 1];
+    }
+    recorder.Record(keys);
+    recorded.emplace_back(keys, keys + REPLAY_KEYS);
+  }
+  CHECK(recorder.Ticks() == TICKS);
+  CHECK(recorder.Save(REPLAY_FILE, 42));
+
+  InputPlayer player;
+  CHECK(player.Load(REPLAY_FILE));
+  CHECK(player.Header.Ticks == TICKS && player.Header.FinalHash == 42);
+  bool replayed[REPLAY_KEYS] = { };
+  unsigned int mismatches = 0;
+  for (unsigned int tick = 0; !player.Done(); tick++) {
+    player.Apply(replayed);
+    mismatches += tick >= TICKS || !std::equal(replayed, replayed + REPLAY_KEYS, recorded[tick].begin());
+  }
+  CHECK(mismatches == 0);
+  std::remove(REPLAY_FILE);
+}
+
+TEST(ReplayStopsAtTruncatedEvent) {
+  ReplayHeader header;
+  std::memcpy(header.Magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+  header.Version = REPLAY_VERSION;
+  header.Flags = 0;
+  header.Step = 1.0f / 240.0f;
+  header.Ticks = 10;
+  header.FinalHash = 0;
+
+  // key 5 pressed on tick 0 (0x405 as a two-byte varint), then a varint whose last byte is missing
+  const unsigned char events[] = { 0x85, 0x08, 0x80, 0x80 };
+  {
+    std::ofstream out(REPLAY_FILE, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(events), sizeof(events));
+  }
+
+  InputPlayer player;
+  CHECK(player.Load(REPLAY_FILE));
+  bool keys[REPLAY_KEYS] = { };
+  unsigned int ticks = 0;
+  for (; !player.Done() && ticks < 100; ticks++)
+    player.Apply(keys);
+  CHECK(ticks == 10);
+  CHECK(keys[5]);
+  CHECK(std::count(keys, keys + REPLAY_KEYS, true) == 1);
+  std::remove(REPLAY_FILE);
+}
+
+TEST(ReplayReproducesStateHash) {
+  const unsigned int TICKS = 20000;
+  const float STEP = 1.0f / 240.0f;
+  unsigned int random = 7;
+
+  // Game keeps its renderer and objects in globals, so one instance serves both runs
+  ResourceManager::Headless = true;
+  Game game(800, 600);
+  game.Init();
+  InputRecorder recorder;
+  recorder.Begin(STEP, 0);
+  for (unsigned int tick = 0; tick < TICKS; tick++) {
+    game.Keys[GLFW_KEY_SPACE] = true;
+    if (tick % 120 == 0) {
+      game.Keys[GLFW_KEY_A] = nextRandom(random) % 2;
+      game.Keys[GLFW_KEY_D] = !game.Keys[GLFW_KEY_A] && nextRandom(random) % 2;
+    }
+    recorder.Record(game.Keys);
+    game.Tick(STEP);
+  }
+  uint64_t recordedHash = game.StateHash();
+  CHECK(recorder.Save(REPLAY_FILE, recordedHash));
+
+  InputPlayer player;
+  CHECK(player.Load(REPLAY_FILE));
+  ResourceManager::Clear();
+  std::memset(game.Keys, 0, sizeof(game.Keys));
+  game.Init();
+  while (!player.Done()) {
+    player.Apply(game.Keys);
+    game.Tick(player.Header.Step);
+  }
+  CHECK(game.StateHash() == recordedHash);
+  CHECK(player.Header.FinalHash == recordedHash);
+
+  ResourceManager::Clear();
+  std::remove(REPLAY_FILE);
+}
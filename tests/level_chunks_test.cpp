@@ -0,0 +1,82 @@
+#include "test.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "level_chunks.hpp"
+
+static const char *CHUNKED_FILE = "/tmp/breakout_test_level.blvl";
+
+TEST(ChunkedLevelPadsWithEmptyTiles) {
+  // 13 x 6 without any empty tile, so padding to 4 x 4 chunks needs a code 0 in the palette
+  LevelData level;
+  CHECK(LoadLevelFile("levels/four.lvl", level));
+  CHECK(WriteLevelChunked(CHUNKED_FILE, level, 4));
+
+  LevelChunks chunks;
+  CHECK(chunks.Open(CHUNKED_FILE));
+  CHECK(chunks.Width == level.Width && chunks.Height == level.Height);
+  CHECK(chunks.ChunksX == 4 && chunks.ChunksY == 2);
+  chunks.Require(0, 0, chunks.ChunksX * 4 - 1, chunks.ChunksY * 4 - 1);
+  for (unsigned int y = 0; y < chunks.ChunksY * 4; y++) {
+    for (unsigned int x = 0; x < chunks.ChunksX * 4; x++)
+      CHECK(chunks.At(x, y) == (x < level.Width && y < level.Height ? level.At(x, y) : 0));
+  }
+  std::remove(CHUNKED_FILE);
+}
+
+static std::vector<uint8_t> readFile(const char *path) {
+  std::vector<uint8_t> data;
+  if (FILE *in = std::fopen(path, "rb")) {
+    int c;
+    while ((c = std::fgetc(in)) != EOF)
+      data.push_back(c);
+    std::fclose(in);
+  }
+  return data;
+}
+
+static bool openBytes(const std::vector<uint8_t> &data, size_t size) {
+  FILE *out = std::fopen(CHUNKED_FILE, "wb");
+  std::fwrite(data.data(), 1, size, out);
+  std::fclose(out);
+  LevelChunks chunks;
+  return chunks.Open(CHUNKED_FILE);
+}
+
+TEST(ChunkedLevelRejectsCorruptFiles) {
+  LevelData level;
+  CHECK(LoadLevelFile("levels/one.lvl", level));
+  CHECK(WriteLevelChunked(CHUNKED_FILE, level, 4));
+  std::vector<uint8_t> data = readFile(CHUNKED_FILE);
+  CHECK(openBytes(data, data.size()));
+
+  // cut anywhere, from inside the chunk info to the last payload byte
+  for (size_t size = sizeof(LevelFileHeader) + sizeof(LevelChunkInfo); size < data.size(); size++)
+    CHECK(!openBytes(data, size));
+
+  // a palette size pointing past the end of the file
+  std::vector<uint8_t> corrupt = data;
+  LevelFileHeader header;
+  std::memcpy(&header, corrupt.data(), sizeof(header));
+  header.PaletteSize = 200;
+  std::memcpy(corrupt.data(), &header, sizeof(header));
+  CHECK(!openBytes(corrupt, corrupt.size()));
+
+  // chunks that don't cover the level, and a zero chunk size
+  size_t infoOffset = sizeof(LevelFileHeader) + reinterpret_cast<LevelFileHeader *>(data.data())->PaletteSize;
+  LevelChunkInfo info;
+  std::memcpy(&info, data.data() + infoOffset, sizeof(info));
+  LevelChunkInfo bad = info;
+  bad.ChunksX--;
+  corrupt = data;
+  std::memcpy(corrupt.data() + infoOffset, &bad, sizeof(bad));
+  CHECK(!openBytes(corrupt, corrupt.size()));
+  bad = info;
+  bad.ChunkSize = 0;
+  std::memcpy(corrupt.data() + infoOffset, &bad, sizeof(bad));
+  CHECK(!openBytes(corrupt, corrupt.size()));
+
+  std::remove(CHUNKED_FILE);
+}
@@ -0,0 +1,62 @@
+#include "test.hpp"
+
+#include <cstring>
+
+#include "level_data.hpp"
+
+static std::vector<uint8_t> binaryLevel(uint32_t width, uint32_t height, const std::vector<uint8_t> &payload, uint16_t flags = 0) {
+  LevelFileHeader header;
+  std::memcpy(header.Magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC));
+  header.Version = LEVEL_VERSION;
+  header.Flags = flags;
+  header.Width = width;
+  header.Height = height;
+  header.PaletteSize = 2;
+  header.PayloadSize = payload.size();
+
+  std::vector<uint8_t> data(sizeof(header));
+  std::memcpy(data.data(), &header, sizeof(header));
+  data.push_back(0);
+  data.push_back(1);
+  data.insert(data.end(), payload.begin(), payload.end());
+  return data;
+}
+
+TEST(ReadLevelBinaryRaw) {
+  std::vector<uint8_t> data = binaryLevel(2, 2, { 0, 1, 1, 0 });
+  LevelData level;
+  LevelError error;
+  CHECK(ReadLevelBinary(data.data(), data.size(), level, error));
+  CHECK(level.Width == 2 && level.Height == 2);
+  CHECK(level.At(1, 0) == 1 && level.At(1, 1) == 0);
+}
+
+TEST(ReadLevelBinaryRejectsZeroSize) {
+  LevelData level;
+  LevelError error;
+  std::vector<uint8_t> data = binaryLevel(0, 4, { });
+  CHECK(!ReadLevelBinary(data.data(), data.size(), level, error));
+  data = binaryLevel(4, 0, { });
+  CHECK(!ReadLevelBinary(data.data(), data.size(), level, error));
+  CHECK(error.Message == "level has no tiles");
+}
+
+TEST(ReadLevelBinaryRejectsOversizedHeader) {
+  // a 65536x65536 level backed by a handful of bytes is refused before any tiles are allocated
+  LevelData level;
+  LevelError error;
+  std::vector<uint8_t> data = binaryLevel(65536, 65536, { 0, 1, 1, 0 });
+  CHECK(!ReadLevelBinary(data.data(), data.size(), level, error));
+  CHECK(error.Message == "payload size does not match the level");
+  CHECK(level.Tiles.empty());
+
+  data = binaryLevel(65536, 65536, { 255, 0, 255, 1 }, LEVEL_FLAG_RLE);
+  CHECK(!ReadLevelBinary(data.data(), data.size(), level, error));
+  CHECK(error.Message == "runs do not cover the level");
+  CHECK(level.Tiles.empty());
+
+  // the largest level two runs can cover still loads
+  data = binaryLevel(255, 2, { 255, 0, 255, 1 }, LEVEL_FLAG_RLE);
+  CHECK(ReadLevelBinary(data.data(), data.size(), level, error));
+  CHECK(level.At(254, 0) == 0 && level.At(0, 1) == 1);
+}
@@ -0,0 +1,33 @@
+#include "test.hpp"
+
+#include <cstring>
+
+unsigned int TestFailures = 0;
+
+std::vector<TestCase> &TestCases() {
+  static std::vector<TestCase> cases;
+  return cases;
+}
+
+// tests [name...]: runs every case, or only the named ones; run from the repository root like
+// the game, some cases read levels/
+int main(int argc, char *argv[]) {
+  unsigned int run = 0, failed = 0;
+  for (const TestCase &test : TestCases()) {
+    bool selected = argc < 2;
+    for (int i = 1; i < argc; i++)
+      selected |= std::strcmp(argv[i], test.Name) == 0;
+    if (!selected)
+      continue;
+
+    unsigned int before = TestFailures;
+    test.Run();
+    run++;
+    if (TestFailures != before) {
+      std::cerr << "FAILED " << test.Name << "\n";
+      failed++;
+    }
+  }
+  std::cout << run << " tests, " << failed << " failed\n";
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,39 @@
+#include "test.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "profiler.hpp"
+
+static const char *TRACE_FILE = "/tmp/breakout_test_trace.json";
+
+TEST(ProfilerDumpsWhileRecording) {
+  // every zone lasts exactly 1us, so a torn event shows up as any other duration
+  std::atomic<bool> recording(true);
+  std::thread writer([&recording] {
+    for (uint64_t time = 1000000; recording.load(std::memory_order_relaxed); time += 2000)
+      Profiler::Record("zone", time, time + 1000);
+  });
+
+  for (unsigned int dump = 0; dump < 20; dump++) {
+    CHECK(Profiler::Dump(TRACE_FILE));
+    std::ifstream in(TRACE_FILE);
+    std::stringstream trace;
+    trace << in.rdbuf();
+    std::string text = trace.str();
+
+    unsigned int events = 0;
+    for (size_t at = text.find("\"dur\":"); at != std::string::npos; at = text.find("\"dur\":", at + 1)) {
+      CHECK(text.compare(at + 6, 5, "1.000") == 0);
+      events++;
+    }
+    CHECK(events <= Profiler::RING_SIZE);
+  }
+
+  recording = false;
+  writer.join();
+  std::remove(TRACE_FILE);
+}
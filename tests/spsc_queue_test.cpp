@@ -0,0 +1,57 @@
+#include "test.hpp"
+
+#include <thread>
+
+#include "spsc_queue.hpp"
+
+TEST(SpscQueueRejectsPushWhenFull) {
+  SpscQueue<unsigned int, 8> queue;
+  for (unsigned int i = 0; i < 8; i++)
+    CHECK(queue.Push(i));
+  CHECK(!queue.Push(8));
+
+  // one pop makes room for exactly one more
+  unsigned int item;
+  CHECK(queue.Pop(item) && item == 0);
+  CHECK(queue.Push(8));
+  CHECK(!queue.Push(9));
+}
+
+TEST(SpscQueueKeepsOrderAcrossWrap) {
+  // head and tail run through the ring many times over
+  SpscQueue<unsigned int, 4> queue;
+  unsigned int pushed = 0, popped = 0, outOfOrder = 0, item;
+  for (unsigned int round = 0; round < 1000; round++) {
+    for (unsigned int i = 0; i < 1 + round % 4; i++)
+      CHECK(queue.Push(pushed++));
+    while (queue.Pop(item))
+      outOfOrder += item != popped++;
+  }
+  CHECK(outOfOrder == 0);
+  CHECK(popped == pushed);
+  CHECK(!queue.Pop(item));
+}
+
+TEST(SpscQueueKeepsOrderAcrossThreads) {
+  const unsigned int ITEMS = 200000;
+  SpscQueue<unsigned int, 256> queue;
+  std::thread producer([&queue] {
+    for (unsigned int i = 0; i < ITEMS; ) {
+      if (queue.Push(i))
+        i++;
+      else
+        std::this_thread::yield();
+    }
+  });
+
+  unsigned int expected = 0, outOfOrder = 0, item;
+  while (expected < ITEMS) {
+    if (!queue.Pop(item)) {
+      std::this_thread::yield();
+      continue;
+    }
+    outOfOrder += item != expected++;
+  }
+  producer.join();
+  CHECK(outOfOrder == 0);
+}
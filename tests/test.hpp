@@ -0,0 +1,31 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+
+// TEST(name) registers a case run by tests/main.cpp; CHECK(condition) reports a failure and
+// carries on with the case, so one run lists everything that broke.
+struct TestCase {
+  const char *Name;
+  void (*Run)();
+};
+
+std::vector<TestCase> &TestCases();
+extern unsigned int TestFailures;
+
+struct TestRegistration {
+  TestRegistration(const char *name, void (*run)()) { TestCases().push_back({ name, run }); }
+};
+
+#define TEST(name) \
+  static void name(); \
+  static TestRegistration name##Registration(#name, name); \
+  static void name()
+
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition "\n"; \
+      TestFailures++; \
+    } \
+  } while (0)
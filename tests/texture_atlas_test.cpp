@@ -0,0 +1,50 @@
+#include "test.hpp"
+
+#include "texture_atlas.hpp"
+
+static bool overlaps(const AtlasRect &a, const AtlasRect &b, unsigned int padding) {
+  // padded rects may touch but not share a pixel
+  return a.X - padding < b.X + b.Width + padding && b.X - padding < a.X + a.Width + padding
+      && a.Y - padding < b.Y + b.Height + padding && b.Y - padding < a.Y + a.Height + padding;
+}
+
+TEST(AtlasPackerPadsWithoutOverlap) {
+  const unsigned int PADDING = 2;
+  std::vector<glm::uvec2> sizes = { { 64, 64 }, { 128, 32 }, { 30, 70 }, { 64, 64 }, { 200, 10 }, { 1, 1 }, { 90, 33 } };
+  AtlasPacker packer(256, PADDING);
+  std::vector<AtlasRect> rects;
+  CHECK(packer.Pack(sizes, rects));
+  CHECK(rects.size() == sizes.size());
+
+  for (unsigned int i = 0; i < rects.size(); i++) {
+    CHECK(rects[i].Width == sizes[i].x && rects[i].Height == sizes[i].y);
+    // the padding around every image stays inside the atlas
+    CHECK(rects[i].X >= PADDING && rects[i].Y >= PADDING);
+    CHECK(rects[i].X + rects[i].Width + PADDING <= packer.Width);
+    CHECK(rects[i].Y + rects[i].Height + PADDING <= packer.Height);
+    CHECK(packer.Width <= 256);
+    for (unsigned int j = i + 1; j < rects.size(); j++)
+      CHECK(!overlaps(rects[i], rects[j], PADDING));
+  }
+}
+
+TEST(AtlasPackerIsDeterministic) {
+  std::vector<glm::uvec2> sizes = { { 16, 16 }, { 16, 16 }, { 8, 16 }, { 16, 8 } };
+  AtlasPacker first(64), second(64);
+  std::vector<AtlasRect> a, b;
+  CHECK(first.Pack(sizes, a) && second.Pack(sizes, b));
+  for (unsigned int i = 0; i < sizes.size(); i++)
+    CHECK(a[i].X == b[i].X && a[i].Y == b[i].Y);
+}
+
+TEST(AtlasPackerReportsImagesTooWide) {
+  // fits on its own, but not once padded
+  std::vector<glm::uvec2> sizes = { { 32, 32 }, { 64, 8 } };
+  AtlasPacker packer(66, 2);
+  std::vector<AtlasRect> rects;
+  CHECK(!packer.Pack(sizes, rects));
+  CHECK(packer.Width == 0 && packer.Height == 0);
+  CHECK(rects.size() == sizes.size());
+  for (const AtlasRect &rect : rects)
+    CHECK(rect.Width == 0 && rect.Height == 0);
+}
@@ -0,0 +1,99 @@
+#include "test.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "hash.hpp"
+#include "texture_cache.hpp"
+
+static const char *IMAGE_FILE = "/tmp/breakout_test_texture.ppm";
+
+// a 5x3 RGB image where channel c of pixel (x, y) is 40x + 10y + c
+static std::string writeImage() {
+  std::string image = "P6\n5 3\n255\n";
+  for (unsigned int y = 0; y < 3; y++) {
+    for (unsigned int x = 0; x < 5; x++) {
+      for (unsigned int c = 0; c < 3; c++)
+        image.push_back(40 * x + 10 * y + c);
+    }
+  }
+  std::ofstream(IMAGE_FILE, std::ios::binary) << image;
+
+  // same naming as the cache, so the test can plant its own blobs
+  char name[64];
+  std::snprintf(name, sizeof(name), "/%016llx-3.btex", (unsigned long long)HashBytes(image.data(), image.size()));
+  return TEXTURE_CACHE_DIR + std::string(name);
+}
+
+static void writeBlob(const std::string &path, TextureBlobHeader header, size_t payload) {
+  std::filesystem::create_directories(TEXTURE_CACHE_DIR);
+  std::ofstream out(path, std::ios::binary);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out << std::string(payload, '\0');
+}
+
+static bool isDecoded(const TexturePixels &pixels) {
+  if (pixels.Width != 5 || pixels.Height != 3 || pixels.Channels != 3 || pixels.Levels != 3)
+    return false;
+  // level 1 is 2x1 and level 2 is 1x1, each texel the rounded mean of a 2x2 block above it
+  const unsigned char *level1 = pixels.Data + 5 * 3 * 3, *level2 = level1 + 2 * 1 * 3;
+  for (unsigned int c = 0; c < 3; c++) {
+    if (pixels.Data[(2 * 5 + 4) * 3 + c] != 160 + 20 + c)
+      return false;
+    if (level1[c] != 25 + c || level1[3 + c] != 105 + c || level2[c] != 65 + c)
+      return false;
+  }
+  return true;
+}
+
+TEST(TextureCacheBuildsMips) {
+  std::string blob = writeImage();
+  std::remove(blob.c_str());
+
+  TexturePixels decoded, mapped;
+  CHECK(LoadTexturePixels(IMAGE_FILE, 3, decoded));
+  CHECK(isDecoded(decoded));
+  // the second load maps the blob the first one baked
+  CHECK(LoadTexturePixels(IMAGE_FILE, 3, mapped));
+  CHECK(isDecoded(mapped));
+  CHECK(mapped.Storage != decoded.Storage);
+
+  std::remove(blob.c_str());
+  std::remove(IMAGE_FILE);
+}
+
+TEST(TextureCacheRejectsBadBlobs) {
+  std::string blob = writeImage();
+  TextureBlobHeader good;
+  std::memcpy(good.Magic, TEXTURE_MAGIC, sizeof(TEXTURE_MAGIC));
+  good.Version = TEXTURE_VERSION;
+  good.Channels = 3;
+  good.Width = 5;
+  good.Height = 3;
+  good.Levels = 3;
+  good.Reserved = 0;
+  {
+    std::ifstream in(IMAGE_FILE, std::ios::binary);
+    std::string image((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    good.SourceHash = HashBytes(image.data(), image.size());
+  }
+
+  // each blob has exactly the size its own header asks for, so only the header checks catch it
+  TextureBlobHeader noLevels = good, tooManyLevels = good, otherChannels = good;
+  noLevels.Levels = 0;
+  tooManyLevels.Levels = 8;
+  otherChannels.Channels = 4;
+  for (const TextureBlobHeader &header : { noLevels, tooManyLevels, otherChannels }) {
+    writeBlob(blob, header, MipChainSize(header.Width, header.Height, header.Channels, header.Levels));
+    TexturePixels pixels;
+    CHECK(LoadTexturePixels(IMAGE_FILE, 3, pixels));
+    CHECK(isDecoded(pixels));
+  }
+
+  std::remove(blob.c_str());
+  std::remove(IMAGE_FILE);
+}
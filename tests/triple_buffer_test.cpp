@@ -0,0 +1,64 @@
+#include "test.hpp"
+
+#include <atomic>
+#include <thread>
+
+#include "triple_buffer.hpp"
+
+// every field carries the same sequence number, so a torn read shows up as a mismatch
+struct Stamp {
+  unsigned long A = 0, B = 0, C = 0;
+};
+
+TEST(TripleBufferAcquiresOnlyNewValues) {
+  TripleBuffer<Stamp> buffer;
+  CHECK(!buffer.Acquire());
+
+  buffer.Back() = { 1, 1, 1 };
+  buffer.Publish();
+  CHECK(buffer.Acquire());
+  CHECK(buffer.Front().A == 1);
+  CHECK(!buffer.Acquire());
+  CHECK(buffer.Front().A == 1);
+
+  // only the latest of several publications is seen
+  for (unsigned long i = 2; i <= 4; i++) {
+    buffer.Back() = { i, i, i };
+    buffer.Publish();
+  }
+  CHECK(buffer.Acquire());
+  CHECK(buffer.Front().A == 4);
+  CHECK(!buffer.Acquire());
+}
+
+TEST(TripleBufferHandsOffWholeValues) {
+  const unsigned long VALUES = 200000;
+  TripleBuffer<Stamp> buffer;
+  std::thread writer([&buffer] {
+    for (unsigned long i = 1; i <= VALUES; i++) {
+      Stamp &back = buffer.Back();
+      back.A = i;
+      back.B = i;
+      back.C = i;
+      buffer.Publish();
+      // let the reader in on a single core
+      if (i % 64 == 0)
+        std::this_thread::yield();
+    }
+  });
+
+  unsigned long last = 0, torn = 0, backwards = 0;
+  while (last < VALUES) {
+    if (!buffer.Acquire()) {
+      std::this_thread::yield();
+      continue;
+    }
+    const Stamp &front = buffer.Front();
+    torn += front.A != front.B || front.B != front.C;
+    backwards += front.A <= last;
+    last = front.A;
+  }
+  writer.join();
+  CHECK(torn == 0);
+  CHECK(backwards == 0);
+}
@@ -0,0 +1,53 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "level_chunks.hpp"
+#include "level_data.hpp"
+
+// Converts text levels to the binary format: levels/one.lvl becomes levels/one.blvl
+// --chunked N splits very large levels into N x N tile chunks that the game streams in
+int main(int argc, char *argv[]) {
+  bool rle = true;
+  unsigned int chunkSize = 0;
+  int converted = 0, failed = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--raw") == 0) {
+      rle = false;
+      continue;
+    }
+    if (std::strcmp(argv[i], "--chunked") == 0 && i + 1 < argc) {
+      chunkSize = std::strtoul(argv[++i], nullptr, 10);
+      continue;
+    }
+
+    LevelData level;
+    if (!LoadLevelFile(argv[i], level)) {
+      failed++;
+      continue;
+    }
+
+    std::string output = argv[i];
+    size_t dot = output.rfind('.');
+    if (dot != std::string::npos && output.find('/', dot) == std::string::npos)
+      output.resize(dot);
+    output += ".blvl";
+
+    bool written = chunkSize > 0 ? WriteLevelChunked(output.c_str(), level, chunkSize) : WriteLevelBinary(output.c_str(), level, rle);
+    if (!written) {
+      std::cerr << "Error: Failed to write " << output << "\n";
+      failed++;
+      continue;
+    }
+    std::cout << argv[i] << " -> " << output << " (" << level.Width << "x" << level.Height << ")\n";
+    converted++;
+  }
+
+  if (converted + failed == 0) {
+    std::cerr << "usage: lvlconv [--raw] [--chunked <tiles>] <level.lvl>...\n";
+    return 1;
+  }
+  return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,43 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "texture_cache.hpp"
+
+// Bakes images into the texture cache ahead of time so the first launch skips decoding too.
+// Run it from the game directory. Both channel layouts the game asks for are baked unless
+// --channels picks one (0 keeps the image's own count, 4 is what the sprite atlas uses).
+int main(int argc, char *argv[]) {
+  std::vector<int> channels;
+  int baked = 0, failed = 0;
+
+  std::vector<const char *> files;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--channels") == 0 && i + 1 < argc)
+      channels.push_back(std::atoi(argv[++i]));
+    else
+      files.push_back(argv[i]);
+  }
+  if (channels.empty())
+    channels = { 0, 4 };
+
+  for (const char *file : files) {
+    for (int count : channels) {
+      TexturePixels pixels;
+      if (!LoadTexturePixels(file, count, pixels)) {
+        failed++;
+        continue;
+      }
+      std::cout << file << " -> " << TEXTURE_CACHE_DIR << " (" << pixels.Width << "x" << pixels.Height << "x" << pixels.Channels
+        << ", " << pixels.Levels << " levels)\n";
+      baked++;
+    }
+  }
+
+  if (baked + failed == 0) {
+    std::cerr << "usage: texbake [--channels <n>]... <image>...\n";
+    return 1;
+  }
+  return failed == 0 ? 0 : 1;
+}